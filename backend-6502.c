@@ -79,6 +79,7 @@
  *	State for the current function
  */
 static unsigned frame_len;	/* Number of bytes of stack frame */
+static unsigned arg_len;	/* Number of bytes of arguments */
 static unsigned sp;		/* Stack pointer offset tracking */
 static unsigned unreachable;	/* Code following an unconditional jump */
 static unsigned xlabel;		/* Internal backend generated branches */
@@ -1389,12 +1390,26 @@ void gen_prologue(const char *name)
 void gen_frame(unsigned size, unsigned aframe)
 {
 	frame_len = size;
+	arg_len = aframe;
 	if (size == 0)
 		return;
 
 	sp = 0;
 	/* Maybe shortcut some common values ? */
 
+	/* Leaves are the small hot functions, so spend a few bytes to make
+	   the frame inline rather than through __subysp */
+	if ((func_flags & F_LEAF) && !optsize && size < 256) {
+		output("lda @sp");
+		output("sec");
+		output("sbc #%u", size);
+		output("sta @sp");
+		output("bcs X%d", ++xlabel);
+		output("dec @sp+1");
+		label("X%d", xlabel);
+		invalidate_a();
+		return;
+	}
 	if (size < 256) {
 		load_y(size);
 		output("jsr __subysp");
@@ -1406,14 +1421,9 @@ void gen_frame(unsigned size, unsigned aframe)
 	output("jsr __subyasp");
 }
 
-void gen_epilogue(unsigned size, unsigned argsize)
+/* Throw away the frame and the arguments, and return */
+static void gen_return(unsigned size, unsigned argsize)
 {
-	if (sp)
-		error("sp");
-
-	if (unreachable)
-		return;
-
 	if (!(func_flags & F_VARARG))
 		size += argsize;
 
@@ -1439,6 +1449,17 @@ void gen_epilogue(unsigned size, unsigned argsize)
 	unreachable = 1;
 }
 
+void gen_epilogue(unsigned size, unsigned argsize)
+{
+	if (sp)
+		error("sp");
+
+	if (unreachable)
+		return;
+
+	gen_return(size, argsize);
+}
+
 void gen_label(const char *tail, unsigned n)
 {
 	unreachable = 0;
@@ -1448,6 +1469,12 @@ void gen_label(const char *tail, unsigned n)
 
 unsigned gen_exit(const char *tail, unsigned n)
 {
+	/* If the frame and arguments fit in Y then a leaf leaves with
+	   ldy and jmp __addysp, barely more than the jmp to the shared exit */
+	if ((func_flags & F_LEAF) && !optsize && frame_len + arg_len < 256) {
+		gen_return(frame_len, arg_len);
+		return 1;
+	}
 	/* FIXME */
 #if 0
 	/* For now. We can only do this if argsize is zero or vararg
@@ -68,7 +68,7 @@ extern void invalidate_a(void);
 extern void invalidate_b(void);
 extern void invalidate_d(void);
 extern void invalidate_work(void);
-extern void invalidate_mem(void);
+extern void invalidate_mem(struct node *n);
 extern void set_d_node(struct node *n);
 extern void set_d_node_ptr(struct node *n);
 extern unsigned d_holds_node(struct node *n);
@@ -1,7 +1,5 @@
 /*
  *	Things to improve
- *	- Use the BC register either via a register hint in the compiler or by looking for
- *	  a non pointer arg candidate (especially on 8080 where the loads are expensive)
  *	- Improve initialized variable generation in stack frame creation
  *	- Avoid the two xchg calls on a void function cleanup (see gen_cleanup)
  *	- Do we want a single "LBREF or NREF name print" function
@@ -189,25 +187,29 @@ static void set_de_bc(void)
 }
 
 
-static void writeflush(struct node *n)
+static void writeflush(struct node *n, unsigned locals)
 {
 	switch(n->op) {
-	case T_NREF:
 	case T_LREF:
+		if (!locals)
+			break;
+	case T_NREF:
 	case T_LBREF:
 		n->op = 0xFFFF;	/* invalidate for matches */
 		break;
 	}
 }
 
-static void flush_writeback(void)
+/* Memory has been written. Cached locals only need to go if the write
+   could have reached them (see local_alias) */
+static void flush_writeback(unsigned locals)
 {
 	if (bc_valid == 2)
-		writeflush(&bc_node);
+		writeflush(&bc_node, locals);
 	if (de_valid == 2)
-		writeflush(&de_node);
+		writeflush(&de_node, locals);
 	if (hl_valid == 2)
-		writeflush(&hl_node);
+		writeflush(&hl_node, locals);
 }
 
 static void invalidate_all(void)
@@ -215,7 +217,7 @@ static void invalidate_all(void)
 	invalidate_hl();
 	invalidate_de();
 	invalidate_bc();
-	flush_writeback();
+	flush_writeback(1);
 }
 
 /*
@@ -781,18 +783,11 @@ void gen_frame(unsigned size, unsigned aframe)
 	}
 }
 
-void gen_epilogue(unsigned size, unsigned argsize)
+/* Throw away the frame and restore BC if needed */
+static void frame_drop(unsigned size)
 {
 	unsigned x = func_flags & F_VOIDRET;
-	if (sp != 0)
-		error("sp");
 
-	if (unreachable)
-		return;
-
-	/* Return in HL, does need care on stack. TODO: flag void functions
-	   where we can burn the return */
-	sp -= size;
 	if (cpu == 8085 && size <= 255 && size > 4) {
 		ldsi_hl(size);
 		opcode("sphl");
@@ -819,11 +814,26 @@ void gen_epilogue(unsigned size, unsigned argsize)
 		opcode("pop b");
 		invalidate_bc();
 	}
-	/* TODO: make this a little "ret" func as it has several users */
-	if (x)
-		opcode("ret");
-	else
-		opcode("ret");
+}
+
+static void gen_return(unsigned size)
+{
+	frame_drop(size);
+	opcode("ret");
+}
+
+void gen_epilogue(unsigned size, unsigned argsize)
+{
+	if (sp != 0)
+		error("sp");
+
+	if (unreachable)
+		return;
+
+	/* Return in HL, does need care on stack. TODO: flag void functions
+	   where we can burn the return */
+	sp -= size;
+	gen_return(size);
 }
 
 void gen_label(const char *tail, unsigned n)
@@ -841,6 +851,14 @@ unsigned gen_exit(const char *tail, unsigned n)
 {
 	if (unreachable)
 		return 1;
+	/* A leaf with at most four bytes of frame leaves with a pop or two
+	   (and pop b) then ret. That is about the size of the jmp to the
+	   shared exit and saves the jump */
+	if (func_cleanup && (func_flags & F_LEAF) && !optsize && frame_len <= 4) {
+		gen_return(frame_len);
+		unreachable = 1;
+		return 1;
+	}
 	if (func_cleanup) {
 		gen_jump(tail, n);
 		unreachable = 1;
@@ -852,6 +870,28 @@ unsigned gen_exit(const char *tail, unsigned n)
 	}
 }
 
+/* A return of the value of a call by name (see H_RETURN). Drop the frame
+   and BC then jmp so the callee returns to our caller. A new argument is
+   swapped by xthl into our argument slot under the return address */
+static unsigned gen_tailcall(struct node *n)
+{
+	struct node *l = n->left;
+	unsigned move = tail_jump(n, T_CALLNAME, T_LREF, argbase + frame_len);
+
+	if (move == 0)
+		return 0;
+	frame_drop(frame_len);
+	if (move == 2) {
+		opcode("pop d");
+		opcode("xthl");
+		opcode("push d");
+	}
+	opcode("jmp _%s+%u", namestr(l->snum), (unsigned)l->value);
+	invalidate_all();
+	unreachable = 1;
+	return 1;
+}
+
 void gen_jump(const char *tail, unsigned n)
 {
 	/* Force anything deferred to complete before the jump */
@@ -960,8 +1000,8 @@ void gen_switch(unsigned n, unsigned type)
 	opcode("lxi d,Sw%u", n);
 	/* Nothing is preserved over a switch */
 	/* TODO tidy once helper is tidied */
-	printf("\tjmp __switch");
-	helper_type(type, 0);
+	printf("\tjmp ");
+	switch_helper(type);
 	putchar('\n');
 }
 
@@ -1661,6 +1701,7 @@ unsigned gen_direct(struct node *n)
 			if (load_hl_with(r) == 0)
 				error("teq");
 			opcode("shlx");
+			flush_writeback(local_alias(n->left));
 			return 1;
 		}
 		if (s == 1) {
@@ -1677,7 +1718,7 @@ unsigned gen_direct(struct node *n)
 				else
 					invalidate_hl();
 			}
-			flush_writeback();
+			flush_writeback(local_alias(n->left));
 			return 1;
 		}
 		return 0;
@@ -2016,10 +2057,37 @@ static unsigned reg_incdec(unsigned s, int v)
 	return 1;
 }
 
+/* One byte of BC with a constant, op as for reg_logic */
+static void reg_logic_byte(const char *r, unsigned v, unsigned op)
+{
+	static const char *imm[3] = { "ani", "ori", "xri" };
+
+	v &= 0xFF;
+	/* and 0xFF, or 0 and xor 0 leave it alone */
+	if ((op == 0 && v == 0xFF) || (op && v == 0))
+		return;
+	if ((op == 0 && v == 0) || (op == 1 && v == 0xFF)) {
+		opcode("mvi %s,%u", r, v);
+		return;
+	}
+	opcode("mov a,%s", r);
+	opcode("%s %u", imm[op], v);
+	opcode("mov %s,a", r);
+}
+
 static void reg_logic(struct node *n, unsigned s, unsigned op, const char *i)
 {
-	/* TODO : constant optimization */
-	codegen_lr(n->right);
+	struct node *r = n->right;
+
+	if (opt > 1 && r->op == T_CONSTANT) {
+		if (s == 2)
+			reg_logic_byte("b", r->value >> 8, op);
+		reg_logic_byte("c", r->value, op);
+		invalidate_bc();
+		hl_from_reg(n, s);
+		return;
+	}
+	codegen_lr(r);
 	/* HL is now the value to combine with BC */
 	if (opt > 1) {
 		/* TODO - can avoid the reload into HL if NORETURN */
@@ -2030,9 +2098,10 @@ static void reg_logic(struct node *n, unsigned s, unsigned op, const char *i)
 			opcode("mov h,a");
 		}
 		opcode("mov a,c");
-		opcode("%s c", i + 2);
+		opcode("%s l", i + 2);
 		opcode("mov c,a");
 		opcode("mov l,a");
+		invalidate_bc();
 		invalidate_hl();
 	} else {
 		helper(n, i);
@@ -2055,6 +2124,9 @@ unsigned gen_shortcut(struct node *n)
 	if (unreachable)
 		return 1;
 
+	if (n == tail_call && gen_tailcall(n))
+		return 1;
+
 	/* The comma operator discards the result of the left side, then
 	   evaluates the right. Avoid pushing/popping and generating stuff
 	   that is surplus */
@@ -2331,7 +2403,7 @@ unsigned gen_shortcut(struct node *n)
 		case T_PERCENTEQ:
 			/* TODO: spot % 256 case */
 			codegen_lr(r);
-			helper(n, "bcrem");
+			helper_s(n, "bcrem");
 			return 1;
 		case T_SHLEQ:
 			if (r->op == T_CONSTANT) {
@@ -2506,6 +2578,10 @@ unsigned gen_node(struct node *n)
 				return 1;
 			if (hl_contains(n))
 				return 1;
+			if (de_contains(n)) {
+				op_xchg();
+				return 1;
+			}
 			if (bc_contains(n)) {
 				hl_from_reg(n, size);
 				return 1;
@@ -2533,6 +2609,10 @@ unsigned gen_node(struct node *n)
 				return 1;
 			if (hl_contains(n))
 				return 1;
+			if (de_contains(n)) {
+				op_xchg();
+				return 1;
+			}
 			if (bc_contains(n)) {
 				hl_from_reg(n, size);
 				return 1;
@@ -2562,6 +2642,10 @@ unsigned gen_node(struct node *n)
 				return 1;
 			if (hl_contains(n))
 				return 1;
+			if (de_contains(n)) {
+				op_xchg();
+				return 1;
+			}
 			if (bc_contains(n)) {
 				hl_from_reg(n, size);
 				return 1;
@@ -2746,7 +2830,7 @@ unsigned gen_node(struct node *n)
 		invalidate_all();
 		return 1;
 	case T_EQ:
-		flush_writeback();
+		flush_writeback(local_alias(n->left));
 		if (size == 2) {
 			if (cpu == 8085) {
 				opcode("pop d");
@@ -37,6 +37,7 @@ extern int bitcheckb1(uint8_t n);
 extern int bitcheck1(unsigned n, unsigned s);
 extern int bitcheck0(unsigned n, unsigned s);
 extern void gen_cleanup(unsigned v);
+extern unsigned gen_tailcall(struct node *n);
 
 extern unsigned frame_len;	/* Number of bytes of stack frame */
 extern unsigned sp;		/* Stack pointer offset tracking */
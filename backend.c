@@ -8,6 +8,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
@@ -35,10 +36,53 @@ void error(const char *p)
 	exit(1);
 }
 
-static void xread(int fd, void *buf, int len)
+/*
+ *	The tree and header stream is read in blocks and everything that
+ *	parses it works from the buffer. Otherwise we make a system call for
+ *	each node and each byte of literal.
+ */
+
+#define INBUF	512
+
+static uint8_t inbuf[INBUF];
+static uint8_t *inptr;
+static unsigned inlen;
+
+static unsigned in_fill(void)
 {
-	if (read(fd, buf, len) != len)
-		error("short read");
+	int n = read(0, inbuf, INBUF);
+	if (n < 0)
+		error("read");
+	inptr = inbuf;
+	inlen = n;
+	return n;
+}
+
+/* Next byte of input or -1 for end of file */
+static int in_byte(void)
+{
+	if (inlen == 0 && in_fill() == 0)
+		return -1;
+	inlen--;
+	return *inptr++;
+}
+
+static void in_read(void *buf, unsigned len)
+{
+	uint8_t *p = buf;
+	unsigned n;
+	while (len) {
+		if (inlen == 0 && in_fill() == 0)
+			error("short read");
+		n = len;
+		if (n > inlen)
+			n = inlen;
+		memcpy(p, inptr, n);
+		inptr += n;
+		inlen -= n;
+		p += n;
+		len -= n;
+	}
 }
 
 /*
@@ -49,12 +93,38 @@ static void xread(int fd, void *buf, int len)
  *	objects.
  */
 
+#ifdef FUSED
+
+/* In the single process compiler cc0 has left the table in memory */
+extern struct name *fused_names;
+
+char *namestr(register unsigned n)
+{
+	return fused_names[n & 0x7FFF].name;
+}
+
+#else
+
+/* Reads can come up short so keep going until we get it all */
+static void xread(int fd, void *buf, int len)
+{
+	uint8_t *p = buf;
+	int n;
+	while (len) {
+		n = read(fd, p, len);
+		if (n <= 0)
+			error("short read");
+		p += n;
+		len -= n;
+	}
+}
+
 #define NCACHE_SIZE	32
 static struct name names[NCACHE_SIZE];
 static struct name *nhead;
 static unsigned max_name;
 
-char *namestr(register unsigned n)
+static char *name_cache(register unsigned n)
 {
 	register struct name *np = nhead;
 	register struct name *prev = NULL;
@@ -90,19 +160,108 @@ static void init_name_cache(void)
 	nhead = names;
 }
 
+#ifndef HOSTED
+
+/* Native builds don't have the memory to keep the names about */
+char *namestr(unsigned n)
+{
+	return name_cache(n);
+}
+
+#else
+
+/*
+ *	Hosted builds keep every name they have seen in a hash by id. If the
+ *	table is complete when we start we load all of it in one go, if not
+ *	(piped from cc0) we load names as they are referenced. Should we run
+ *	out of memory the LRU cache above does the rest.
+ */
+
+#define NHASH_NAME	256
+
+static struct name *name_hash[NHASH_NAME];
+
+static void name_insert(register struct name *np)
+{
+	register struct name **hp = name_hash + (np->id & (NHASH_NAME - 1));
+	np->next = *hp;
+	*hp = np;
+}
+
+static void name_load_all(void)
+{
+	register struct name *np;
+	register unsigned i;
+	off_t len = lseek(sym_fd, 0L, SEEK_END);
+	unsigned num;
+
+	if (len <= 2)
+		return;
+	num = (len - 2) / sizeof(struct name);
+	np = malloc(num * sizeof(struct name));
+	if (np == NULL)
+		return;
+	if (lseek(sym_fd, 2L, SEEK_SET) < 0)
+		error("seeksym");
+	xread(sym_fd, np, num * sizeof(struct name));
+	for (i = 0; i < num; i++)
+		name_insert(np++);
+}
+
+char *namestr(register unsigned n)
+{
+	register struct name *np = name_hash[n & (NHASH_NAME - 1)];
+	while (np) {
+		if (np->id == n)
+			return np->name;
+		np = np->next;
+	}
+	np = malloc(sizeof(struct name));
+	if (np == NULL)
+		return name_cache(n);
+	if (lseek(sym_fd, 2 + sizeof(struct name) * (n & 0x7FFF), 0) < 0)
+		error("seeksym");
+	xread(sym_fd, np, sizeof(struct name));
+	name_insert(np);
+	return np->name;
+}
+
+#endif
+
+#endif
+
 /*
  *	Expression tree nodes
  */
 #define NUM_NODES 100
 
-static struct node node_table[NUM_NODES];
 static struct node *nodes;
 
+#ifdef NODE_SLABS
+/* Nodes are never given back to malloc, just kept on the free list */
+static void node_slab(void)
+{
+	register int i;
+	register struct node *n = malloc(NUM_NODES * sizeof(struct node));
+	if (n == NULL)
+		error("out of memory");
+	for (i = 0; i < NUM_NODES; i++)
+		free_node(n++);
+}
+#else
+static struct node node_table[NUM_NODES];
+#endif
+
 struct node *new_node(void)
 {
 	register struct node *n;
-	if (nodes == NULL)
+	if (nodes == NULL) {
+#ifdef NODE_SLABS
+		node_slab();
+#else
 		error("Too many nodes");
+#endif
+	}
 	n = nodes;
 	nodes = n->right;
 	n->left = n->right = NULL;
@@ -119,10 +278,14 @@ void free_node(register struct node *n)
 
 void init_nodes(void)
 {
+#ifdef NODE_SLABS
+	node_slab();
+#else
 	register int i;
 	register struct node *n = node_table;
 	for (i = 0; i < NUM_NODES; i++)
 		free_node(n++);
+#endif
 }
 
 void free_tree(register struct node *n)
@@ -163,11 +326,11 @@ static void pop_area(void)
 	}
 }
 
-/* I/O buffering stuff can wait - as can switching to a block write method */
+/* Switching to a block write method can wait */
 static struct node *load_tree(void)
 {
 	register struct node *n = new_node();
-	xread(0, n, sizeof(struct node));
+	in_read(n, sizeof(struct node));
 
 	/* The values off disk are old pointers or NULL, that's good enough
 	   to use as a load flag */
@@ -348,6 +511,41 @@ static void dump_tree(register struct node *n, unsigned depth)
 }
 #endif
 
+/* The tree of a return statement whose value is a call (see H_RETURN).
+   The target may turn the call into a jump */
+struct node *tail_call;
+static unsigned tail_next;
+
+static unsigned argframe_len;
+
+/* Whether the tail call tree n can become a jump. The callee can take no
+   arguments or one word in place of our own single word argument. The
+   target passes its call by name and local load ops, and the stack offset
+   of our argument. Returns 0 if not, 1 if nothing needs moving, or 2 once
+   the new argument is in the working register for the target to swap into
+   our argument slot */
+unsigned tail_jump(struct node *n, unsigned callname, unsigned lref, unsigned own)
+{
+	struct node *l = n->left;
+	struct node *a;
+
+	if (n->op != T_CLEANUP || l->op != callname)
+		return 0;
+	if (n->right->value == 0)
+		return 1;
+	a = l->left;
+	/* One argument pushed as a word */
+	if (n->right->value != 2 || argframe_len != 2 || a->op == T_ARGCOMMA)
+		return 0;
+	if (func_flags & F_VOIDRET)
+		return 0;
+	/* Our own argument passed on unchanged is already in place */
+	if (a->op == lref && a->value == own && a->type != CCHAR && a->type != UCHAR)
+		return 1;
+	codegen_lr(a);
+	return 2;
+}
+
 static unsigned process_expression(void)
 {
 	register struct node *n = load_tree();
@@ -362,7 +560,11 @@ static unsigned process_expression(void)
 	fprintf(stderr, ":rewritten:\n");
 	dump_tree(n, 0);
 #endif
+	if (tail_next)
+		tail_call = n;
+	tail_next = 0;
 	gen_tree(n);
+	tail_call = NULL;
 	t = n->type;
 	free_tree(n);
 	return t;
@@ -376,7 +578,7 @@ static unsigned compile_expression(void)
 	   expression is something like if (x = "eep"). Process up to and
 	   including our expression */
 	do {
-		xread(0, h, 2);
+		in_read(h, 2);
 		t = process_one_block(h);
 	} while (h[1] != '^');
 	return t;
@@ -389,13 +591,83 @@ static unsigned compile_expression(void)
 
 static unsigned func_ret;
 static unsigned frame_len;
-static unsigned argframe_len;
 static unsigned func_ret_used;
 unsigned func_flags;
+unsigned switch_form;		/* Table header type of the current switch */
+
+/*
+ *	Function level output buffering. Normally the code for each tree is
+ *	written as it is generated, so a target can't go back and change its
+ *	prologue once it knows what the body needed. A target that wants to
+ *	calls func_hold() in gen_frame() and the code after that is kept in
+ *	a scratch file. At gen_epilogue() time func_held() hands back the
+ *	body so far as a string. The target then writes out whatever
+ *	prologue it decided on and calls func_release() to follow it with
+ *	the body.
+ */
+
+static int hold_fd = -1;	/* Scratch file, reused for each function */
+static int hold_out = -1;	/* The real output while holding */
+static char *hold_buf;
+static unsigned hold_size;
+static unsigned hold_len;
+
+void func_hold(void)
+{
+	FILE *f;
+
+	if (hold_out != -1)
+		error("hold");
+	if (hold_fd == -1) {
+		f = tmpfile();
+		if (f == NULL)
+			error("tmpfile");
+		hold_fd = fileno(f);
+	}
+	fflush(stdout);
+	lseek(hold_fd, 0L, SEEK_SET);
+	hold_out = dup(1);
+	if (hold_out == -1 || dup2(hold_fd, 1) == -1)
+		error("dup");
+}
+
+char *func_held(void)
+{
+	off_t len;
+
+	if (hold_out == -1)
+		error("held");
+	fflush(stdout);
+	/* The scratch file shares its offset with the output we redirected */
+	len = lseek(hold_fd, 0L, SEEK_CUR);
+	if (dup2(hold_out, 1) == -1)
+		error("dup");
+	close(hold_out);
+	hold_out = -1;
+
+	if (len + 1 > hold_size) {
+		hold_size = len + 1024;
+		hold_buf = realloc(hold_buf, hold_size);
+		if (hold_buf == NULL)
+			error("out of memory");
+	}
+	hold_len = len;
+	lseek(hold_fd, 0L, SEEK_SET);
+	if (read(hold_fd, hold_buf, hold_len) != hold_len)
+		error("read");
+	hold_buf[hold_len] = 0;
+	return hold_buf;
+}
+
+void func_release(void)
+{
+	fwrite(hold_buf, hold_len, 1, stdout);
+	hold_len = 0;
+}
 
 static void process_literal(unsigned id)
 {
-	unsigned char c;
+	int c;
 	register unsigned char shifted = 0;
 
 	gen_literal(id);
@@ -403,7 +675,8 @@ static void process_literal(unsigned id)
 	/* A series of bytes terminated by a 0 marker. Internal
 	   zero is quoted, undo the quoting and turn it into data */
 	while (1) {
-		if (read(0, &c, 1) != 1)
+		c = in_byte();
+		if (c == -1)
 			error("unexpected EOF");
 		if (c == 0) {
 			break;
@@ -424,7 +697,7 @@ static void process_header(void)
 	struct header h;
 	static char tbuf[16];
 
-	xread(0, &h, sizeof(struct header));
+	in_read(&h, sizeof(struct header));
 
 	switch (h.h_type) {
 	case H_EXPORT:
@@ -540,7 +813,7 @@ static void process_header(void)
 			gen_label("_e", h.h_name);
 		break;
 	case H_RETURN:
-//              func_ret_used = 1;
+		tail_next = h.h_data;
 		break;
 	case H_RETURN | H_FOOTER:
 		if (gen_exit("_r", func_ret) == 0)
@@ -556,6 +829,7 @@ static void process_header(void)
 		break;
 	case H_SWITCH:
 		/* Generate the switch header, expression and table run */
+		switch_form = h.h_data;
 		gen_switch(h.h_name, compile_expression());	/* need the type of it back */
 		break;
 	case H_CASE:
@@ -568,10 +842,14 @@ static void process_header(void)
 		gen_label("_b", h.h_data);
 		break;
 	case H_SWITCHTAB:
+	case H_SWITCHJT:
+	case H_SWITCHBS:
 		push_area(A_LITERAL);
 		gen_switchdata(h.h_name, h.h_data);
 		break;
 	case H_SWITCHTAB | H_FOOTER:
+	case H_SWITCHJT | H_FOOTER:
+	case H_SWITCHBS | H_FOOTER:
 		pop_area();
 		break;
 	case H_DATA:
@@ -676,6 +954,37 @@ void helper_type(register unsigned t, unsigned s)
 	}
 }
 
+/* Name the support routine that dispatches the current switch. Only
+   backends whose target_switch() allows other table forms see them */
+void switch_helper(unsigned t)
+{
+	fputs("__switch", stdout);
+	if (switch_form == H_SWITCHJT)
+		fputs("jt", stdout);
+	else if (switch_form == H_SWITCHBS) {
+		/* Compares so signedness matters */
+		fputs("bs", stdout);
+		helper_type(t, 1);
+		return;
+	}
+	helper_type(t, 0);
+}
+
+/* Could a store through the address n change a local ? Not if the
+   function never used the address of one and n isn't worked out from one.
+   Only backends that cache locals in registers (8080/8085 and the 6800
+   family) have anything to gain, the Z80 keeps no register cache */
+unsigned local_alias(register struct node *n)
+{
+	if (!(func_flags & F_NOADDR))
+		return 1;
+	if (n->op == T_LOCAL || n->op == T_ARGUMENT)
+		return 1;
+	if (n->left && local_alias(n->left))
+		return 1;
+	return n->right && local_alias(n->right);
+}
+
 /*
  *	The resulting type of a thing is a bit more complicated than the
  *	type of the node because for example a C == operator acts on two
@@ -936,6 +1245,7 @@ void make_node(register struct node *n)
  *	Load the symbol table from the front end
  */
 
+#ifndef FUSED
 static void load_symbols(const char *path)
 {
 	uint8_t n[2];
@@ -944,9 +1254,17 @@ static void load_symbols(const char *path)
 		perror(path);
 		exit(1);
 	}
-	xread(sym_fd, n, 2);
-	max_name = n[0] | (n[1] << 8);
+	/* When the passes are piped together cc0 may not have written the
+	   size yet. The names we need will be there by the time we see
+	   them referenced */
+	if (read(sym_fd, n, 2) == 2)
+		max_name = n[0] | (n[1] << 8);
+#ifdef HOSTED
+	if (max_name)
+		name_load_all();
+#endif
 }
+#endif
 
 static unsigned process_one_block(register uint8_t *h)
 {
@@ -1077,6 +1395,7 @@ void codegen_lr(register struct node *n)
 int main(int argc, char *argv[])
 {
 	uint8_t h[2];
+	int c;
 
 	argv0 = argv[0];
 
@@ -1095,12 +1414,16 @@ int main(int argc, char *argv[])
 	cpufeat = atol(argv[4]);
 	if (argv[5])
 		codeseg = argv[5];
+#ifndef FUSED
 	init_name_cache();
 	load_symbols(argv[1]);
+#endif
 	init_nodes();
 
 	gen_start();
-	while (read(0, &h, 2) > 0) {
+	while ((c = in_byte()) != -1) {
+		h[0] = c;
+		in_read(h + 1, 1);
 		process_one_block(h);
 	}
 	gen_end();
@@ -16,6 +16,13 @@ extern void do_helper(register struct node *n, const char *h, unsigned t, unsign
 extern void helper(struct node *n, const char *h);
 extern void helper_s(struct node *n, const char *h);
 extern void helper_type(unsigned t, unsigned s);
+extern void switch_helper(unsigned t);
+extern void func_hold(void);
+extern char *func_held(void);
+extern void func_release(void);
+extern unsigned local_alias(struct node *n);
+extern struct node *tail_call;
+extern unsigned tail_jump(struct node *n, unsigned callname, unsigned lref, unsigned own);
 extern void codegen_lr(struct node *n);
 
 extern struct node *gen_rewrite_node(struct node *n);
@@ -73,3 +80,5 @@ extern void make_node(struct node *n);
 #define MAX_SEG		3
 
 extern unsigned func_flags;
+/* H_SWITCHTAB, H_SWITCHJT or H_SWITCHBS for the switch being generated */
+extern unsigned switch_form;
@@ -500,10 +500,14 @@ unsigned write_tos_opd(struct node *n, const char *op, const char *op2)
 {
 	unsigned s = get_size(n->type);
 	if (s == 4) {
-		printf("\t%s 2,s\n", op);
-		printf("\t%s 1,s\n", op2);
-		printf("\t%s ,s\n", op2);
+		/* Low word into D then carry into Y. exg leaves CC alone */
+		printf("\t%sd 2,s\n", op);
+		swap_d_y();
+		printf("\t%sb 1,s\n", op2);
+		printf("\t%sa ,s\n", op2);
+		swap_d_y();
 		puts("\tleas 4,s");
+		invalidate_work();
 		return 1;
 	} else if (s == 2)
 		op16d_on_tos(op);
@@ -652,7 +656,8 @@ unsigned can_load_r_with(struct node *r, unsigned off)
 		return 1;
 	case T_PLUS:
 	case T_MINUS:
-		if (!can_load_r_with(r->left, off))
+		/* Must match what load_r_with can do */
+		if (!can_load_r_simple(r->left, off))
 			return 0;
 		if (r->right->op != T_CONSTANT)
 			return 0;
@@ -699,7 +704,7 @@ static unsigned load_r_with(char reg, struct node *r, unsigned off)
 	case T_MINUS:
 		if (cpu_is_09 && can_load_r_simple(r->left, off) &&
 			r->right->op == T_CONSTANT) {
-			load_r_with(reg, r->right, off);
+			load_r_with(reg, r->left, off);
 			return -r->right->value;
 		}
 		break;
@@ -730,6 +730,7 @@ unsigned gen_uni_direct(struct node *n)
 		printf(";LEQ rv %lu nr %u nv %lu val2 %u s %u\n",
 			r->value, nr, n->value, n->val2, s);
 		if (r->op == T_CONSTANT && r->value == 0 && nr) {
+			invalidate_mem(n);
 			if (cpu_is_09 && n->val2 == 0 && s == 1) {
 				printf("\tclr [%u,s]\n", WORD(n->value));
 				return 1;
@@ -751,6 +752,7 @@ unsigned gen_uni_direct(struct node *n)
 	case T_LBEQ:
 		if (r->op == T_CONSTANT && r->value == 0 && nr) {
 			if (s == 1 && nr) {
+				invalidate_mem(n);
 				printf("\tclr [T%u+%u]\n", n->val2, (unsigned)n->value);
 				return 1;
 			}
@@ -759,6 +761,7 @@ unsigned gen_uni_direct(struct node *n)
 	case T_NEQ:
 		if (r->op == T_CONSTANT && r->value == 0 && nr) {
 			if (s == 1 && nr) {
+				invalidate_mem(n);
 				printf("\tclr [_%s+%u]\n", namestr(n->snum), (unsigned)n->value);
 				return 1;
 			}
@@ -1024,7 +1027,7 @@ unsigned memop_const(struct node *n, const char *op, unsigned nr, unsigned pre)
 			printf("ldb T%u+%u\n", l->val2, v);
 		sprintf(buf, "%s T%u+%u", op, l->val2, v);
 		repeated_op(ct, buf);
-		invalidate_mem();
+		invalidate_mem(l);
 		if (pre == 2)
 			printf("ldb T%u+%u\n", l->val2, v);
 		if (pre)
@@ -1035,7 +1038,7 @@ unsigned memop_const(struct node *n, const char *op, unsigned nr, unsigned pre)
 			printf("ldb _%s+%u\n", namestr(l->snum), v);
 		sprintf(buf, "%s _%s+%u", op, namestr(l->snum), v);
 		repeated_op(ct, buf);
-		invalidate_mem();
+		invalidate_mem(l);
 		if (pre == 2)
 			printf("ldb _%s+%u\n", namestr(l->snum), v);
 		if (pre)
@@ -1048,7 +1051,7 @@ unsigned memop_const(struct node *n, const char *op, unsigned nr, unsigned pre)
 			uniop_on_ptr("ldb", v, 1);
 		while(ct--)
 			uniop_on_ptr(op, v, 1);
-		invalidate_mem();
+		invalidate_mem(l);
 		if (pre == 2)
 			uniop_on_ptr("ldb", v, 1);
 		if (pre)
@@ -1084,12 +1087,12 @@ unsigned memop_shift(struct node *n, const char *op, const char *opu)
 	case T_LABEL:
 		sprintf(buf, "%s T%u+%u", op, l->val2, v);
 		repeated_op(r->value, buf);
-		invalidate_mem();
+		invalidate_mem(l);
 		return 1;
 	case T_NAME:
 		sprintf(buf, "%s _%s+%u", op, namestr(l->snum), v);
 		repeated_op(r->value, buf);
-		invalidate_mem();
+		invalidate_mem(l);
 		return 1;
 	case T_ARGUMENT:
 	case T_LOCAL:
@@ -1098,7 +1101,7 @@ unsigned memop_shift(struct node *n, const char *op, const char *opu)
 			return 0;
 		sprintf(buf, "%s %u,s", op, v + sp);
 		repeated_op(r->value, buf);
-		invalidate_mem();
+		invalidate_mem(l);
 		return 1;
 	}
 	return 0;
@@ -1151,7 +1154,7 @@ unsigned add_to_node(struct node *n, int sign, int retres)
 				puts("\tpulb");
 		}
 		invalidate_work();
-		invalidate_mem();
+		invalidate_mem(l);
 		if (retres)
 			set_d_node(l);
 		return 1;
@@ -1172,7 +1175,7 @@ unsigned add_to_node(struct node *n, int sign, int retres)
 			puts("\tpula\n\tpulb");
 	}
 	invalidate_work();
-	invalidate_mem();
+	invalidate_mem(l);
 	if (retres)
 		set_d_node_ptr(l);
 	return 1;
@@ -1336,7 +1339,7 @@ unsigned gen_shortcut(struct node *n)
 			}
 			codegen_lr(r);
 			v += load_x_with(l, 0);
-			invalidate_mem();
+			invalidate_mem(l);
 			if (s == 4)
 				store32(v, nr);
 			else
@@ -1368,7 +1371,7 @@ unsigned gen_shortcut(struct node *n)
 			invalidate_work();
 
 			/* Store */
-			invalidate_mem();
+			invalidate_mem(l);
 			if (s == 4)
 				store32(v, nr);
 			else
@@ -1445,7 +1448,13 @@ unsigned gen_shortcut(struct node *n)
 #endif
 	case T_RSTORE:
 		if (can_load_r_with(r, 0)) {
-			load_u_with(r, 0);
+			v = load_u_with(r, 0);
+			if (v)
+				printf("\tleau %d,u\n", (int)v);
+			if (!nr) {
+				puts("\ttfr u,d");
+				invalidate_work();
+			}
 			return 1;
 		}
 		codegen_lr(r);
@@ -1587,7 +1596,7 @@ unsigned gen_node(struct node *n)
 		return 1;
 	case T_EQ:	/* Assign - ToS is address, working value is value */
 	case T_EQPLUS:
-		invalidate_mem();
+		invalidate_mem(n->left);
 		if (s == 1) {
 			pop_x();
 			op8_on_ptr("st", v);
@@ -1673,7 +1682,7 @@ unsigned gen_node(struct node *n)
 	case T_NSTORE:
 	case T_LBSTORE:
 		if (write_opd(n, "st", "st", 0)) {
-			invalidate_mem();
+			invalidate_mem(n);
 			set_d_node(n);
 			return 1;
 		}
@@ -1794,6 +1803,7 @@ unsigned gen_node(struct node *n)
 		invalidate_work();
 		return 1;
 	case T_LEQ:
+		invalidate_mem(n);
 		/* We probably want some indirecting helpers later */
 		if (cpu_is_09) {
 			if (n->val2 == 0 && s <= 2) {
@@ -1819,12 +1829,14 @@ unsigned gen_node(struct node *n)
 			op32d_on_ptr("st", "st", n->val2);
 		return 1;
 	case T_NEQ:
+		invalidate_mem(n);
 		if (s == 1)
 			printf("\tstb [_%s + %u]\n", namestr(n->snum), v);
 		else
 			printf("\tstd [_%s + %u]\n", namestr(n->snum), v);
 		return 1;
 	case T_LBEQ:
+		invalidate_mem(n);
 		if (s == 1)
 			printf("\tstb [T%u + %u]\n", n->val2, v);
 		else
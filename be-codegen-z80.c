@@ -1259,17 +1259,40 @@ static void reghelper(struct node *n, const char *p)
 	helper(n, p);
 }
 
+/* One byte of BC with a constant, op as for reg_logic */
+static void reg_logic_byte(const char *r, unsigned v, unsigned op)
+{
+	static const char *imm[3] = { "and", "or", "xor" };
+
+	v &= 0xFF;
+	/* and 0xFF, or 0 and xor 0 leave it alone */
+	if ((op == 0 && v == 0xFF) || (op && v == 0))
+		return;
+	if ((op == 0 && v == 0) || (op == 1 && v == 0xFF)) {
+		printf("\tld %s,0x%x\n", r, v);
+		return;
+	}
+	printf("\tld a,%s\n\t%s 0x%x\n\tld %s,a\n", r, imm[op], v, r);
+}
+
 static void reg_logic(register struct node *n, unsigned s, unsigned op, const char *i)
 {
-	/* TODO : constant optimization */
-	codegen_lr(n->right);
+	struct node *r = n->right;
+
+	if (opt > 1 && n->left->value == 1 && r->op == T_CONSTANT) {
+		if (s == 2)
+			reg_logic_byte("b", r->value >> 8, op);
+		reg_logic_byte("c", r->value, op);
+		get_regvar(1, n, s);
+		return;
+	}
+	codegen_lr(r);
 	/* HL is now the value to combine with BC */
 	if (opt > 1 && n->left->value == 1) {
 		/* TODO - can avoid the reload into HL if NORETURN */
-		/* TODO: check we never end up with IX or IY here */
 		if (s == 2)
 			printf("\tld a,b\n\t%s h\n\tld b,a\n\tld h,a\n", i + 2);
-		printf("\tld a,c\n\t%s c\n\tld c,a\n\tld l,a\n", i + 2);
+		printf("\tld a,c\n\t%s l\n\tld c,a\n\tld l,a\n", i + 2);
 	} else {
 		reghelper(n, i);
 		get_regvar(n->left->value, NULL, s);
@@ -1382,6 +1405,9 @@ unsigned gen_shortcut(register struct node *n)
 	if (unreachable)
 		return 1;
 
+	if (n == tail_call && gen_tailcall(n))
+		return 1;
+
 	/* Try and rewrite this node subtree for CC only */
 	if ((opt || optsize) && (n->flags & CCONLY))
 		propogate_cconly(n);
@@ -1702,7 +1728,7 @@ unsigned gen_shortcut(register struct node *n)
 		case T_PERCENTEQ:
 			/* TODO: spot % 256 case */
 			codegen_lr(r);
-			reghelper(n, "bcrem");
+			reghelper_s(n, "bcrem");
 			return 1;
 		case T_SHLEQ:
 			/* TODO IX and IY for the simple cases */
@@ -30,6 +30,7 @@ unsigned frame_len;		/* Number of bytes of stack frame */
 unsigned argbase;		/* Argument offset in current function */
 unsigned sp;			/* Stack pointer offset tracking */
 unsigned unreachable;		/* Code following an unconditional jump */
+static unsigned arg_len;	/* Argument bytes in current function */
 
 /* Export the C symbol */
 void gen_export(const char *name)
@@ -76,13 +77,13 @@ void gen_frame(unsigned size, unsigned aframe)
 	/* TODO: there is an optimization trick here for 09 where you
 	   can use a pshs combining the pshs u to make some size of frame */
 	frame_len = size;
+	arg_len = aframe;
 	adjust_s(-size, 0);
 }
 
-void gen_epilogue(unsigned size, unsigned argsize)
+/* Throw away the frame, restore U if needed and return */
+static void gen_return(unsigned size, unsigned argsize)
 {
-	if (sp)
-		error("sp");
 	adjust_s(size, (func_flags & F_VOIDRET) ? 0 : 1);
 	if (func_flags & F_REG(1))
 		/* 6809 only */
@@ -101,6 +102,16 @@ void gen_epilogue(unsigned size, unsigned argsize)
 	unreachable = 1;
 }
 
+void gen_epilogue(unsigned size, unsigned argsize)
+{
+	if (sp)
+		error("sp");
+	/* We may have returned inline already (see gen_exit) */
+	if (unreachable)
+		return;
+	gen_return(size, argsize);
+}
+
 void gen_label(const char *tail, unsigned n)
 {
 	invalidate_all();
@@ -110,6 +121,13 @@ void gen_label(const char *tail, unsigned n)
 
 unsigned gen_exit(const char *tail, unsigned n)
 {
+	/* On the 6809 a leaf drops its frame with a leas and returns with
+	   rts or puls u,pc so repeat that here. The 6800 has no cheap way
+	   to drop a frame so only does it when there is none */
+	if ((func_flags & F_LEAF) && !optsize && (cpu_is_09 || frame_len == 0)) {
+		gen_return(frame_len, arg_len);
+		return 1;
+	}
 	printf("\t%s L%d%s\n", jmp_op, n, tail);
 	unreachable = 1;
 	return 0;
@@ -139,8 +157,8 @@ void gen_jtrue(const char *tail, unsigned n)
 
 void gen_switch(unsigned n, unsigned type)
 {
-	printf("\tldx #Sw%u\n\t%s __switch", n, jmp_op);
-	helper_type(type, 0);
+	printf("\tldx #Sw%u\n\t%s ", n, jmp_op);
+	switch_helper(type);
 	putchar('\n');
 }
 
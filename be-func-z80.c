@@ -45,6 +45,25 @@ void gen_prologue(const char *name)
 	unreachable = 0;
 }
 
+/* Move the stack pointer down over the locals */
+static void frame_adjust(unsigned size)
+{
+	if (size > 10) {
+		printf("\tld hl,0x%x\n", (uint16_t) -size);
+		printf("\tadd hl,sp\n");
+		printf("\tld sp,hl\n");
+		return;
+	}
+	if (size & 1) {
+		printf("\tdec sp\n");
+		size--;
+	}
+	while(size) {
+		printf("\tpush hl\n");
+		size -= 2;
+	}
+}
+
 /* Generate the stack frame */
 /* TODO: defer this to statements so we can ld/push initializers */
 void gen_frame(unsigned size,  unsigned aframe)
@@ -79,49 +98,41 @@ void gen_frame(unsigned size,  unsigned aframe)
 		/* IY is free use it as a frame pointer ? */
 		if (!optsize && size > 4) {
 			argbase += 2;
-			printf("\tpush iy\n");
 			/* Remember we need to restore IY */
 			func_flags |= F_REG(3);
 			use_fp = 1;
 		}
 	}
-	/* If we are building a frame pointer we need to do this work anyway */
+	/* Hold the body back until we know if it used the frame pointer */
 	if (use_fp) {
+		func_hold();
+		return;
+	}
+	frame_adjust(size);
+}
+
+/* The body is done so we know if it used the frame pointer. If it did
+   then set it up, if not then the slot IY would have been saved in is
+   made part of the locals instead so no offsets change */
+static unsigned frame_finish(unsigned size)
+{
+	if (strstr(func_held(), "(iy")) {
+		printf("\tpush iy\n");
 		printf("\tld iy,0x%x\n", (uint16_t) - size);
 		printf("\tadd iy,sp\n");
 		printf("\tld sp,iy\n");
-		return;
-	}
-	if (size > 10) {
-		printf("\tld hl,0x%x\n", (uint16_t) -size);
-		printf("\tadd hl,sp\n");
-		printf("\tld sp,hl\n");
-		return;
-	}
-	if (size & 1) {
-		printf("\tdec sp\n");
-		size--;
-	}
-	while(size) {
-		printf("\tpush hl\n");
-		size -= 2;
+	} else {
+		func_flags &= ~F_REG(3);
+		size += 2;
+		frame_adjust(size);
 	}
+	func_release();
+	return size;
 }
 
-void gen_epilogue(register unsigned size, unsigned argsize)
+/* Throw away the frame and restore any registers */
+static void frame_drop(register unsigned size)
 {
-	if (sp != 0)
-		error("sp");
-
-	/* Return in HL, does need care on stack. TOOD: flag void functions
-	   where we can burn the return */
-	sp -= size;
-
-	/* This can happen if the function never returns or the only return
-	   is a by a ret directly (ie from a function without locals) */
-	if (unreachable)
-		return;
-
 	if (size > 10) {
 		unsigned x = func_flags & F_VOIDRET;
 		if (!x)
@@ -147,10 +158,61 @@ void gen_epilogue(register unsigned size, unsigned argsize)
 		printf("\tpop ix\n");
 	if (func_flags & F_REG(1))
 		printf("\tpop bc\n");
+}
+
+static void gen_return(unsigned size)
+{
+	frame_drop(size);
 	printf("\tret\n");
 	unreachable = 1;
 }
 
+/* A return of the value of a call by name (see H_RETURN). Drop the frame
+   and the saved BC, IX and IY then jp so the callee returns to our caller.
+   A new argument is swapped by ex (sp),hl into our argument slot */
+unsigned gen_tailcall(struct node *n)
+{
+	struct node *l = n->left;
+	unsigned move;
+
+	/* Banked code has the bank word on the stack, and an IY frame is
+	   only set up once the body is done, so take the normal exit */
+	if ((cpufeat & 1) || use_fp)
+		return 0;
+	move = tail_jump(n, T_CALLNAME, T_LREF, argbase + frame_len);
+	if (move == 0)
+		return 0;
+	frame_drop(frame_len);
+	if (move == 2) {
+		printf("\tpop de\n");
+		printf("\tex (sp),hl\n");
+		printf("\tpush de\n");
+	}
+	printf("\tjp _%s+%u\n", namestr(l->snum), (unsigned)l->value);
+	unreachable = 1;
+	return 1;
+}
+
+void gen_epilogue(register unsigned size, unsigned argsize)
+{
+	if (sp != 0)
+		error("sp");
+
+	if (use_fp)
+		size = frame_finish(size);
+
+	/* Return in HL, does need care on stack. TOOD: flag void functions
+	   where we can burn the return */
+	sp -= size;
+
+	/* This can happen if the function never returns or the only return
+	   is a by a ret directly (ie from a function without locals) */
+	if (unreachable)
+		return;
+
+	gen_return(size);
+}
+
 void gen_label(const char *tail, unsigned n)
 {
 	unreachable = 0;
@@ -161,6 +223,16 @@ void gen_label(const char *tail, unsigned n)
    no cleanup to do */
 unsigned gen_exit(const char *tail, unsigned n)
 {
+	if (unreachable)
+		return 1;
+	/* Without IY as a frame pointer and with at most four bytes of frame
+	   a leaf leaves with a pop or two, the saved registers and ret. That
+	   is little bigger than the jr to the shared exit */
+	if (func_cleanup && (func_flags & F_LEAF) && !optsize && !use_fp &&
+	    frame_len <= 4) {
+		gen_return(frame_len);
+		return 1;
+	}
 	if (func_cleanup) {
 		gen_jump(tail, n);
 		return 0;
@@ -268,8 +340,8 @@ void gen_helpclean(register struct node *n)
 void gen_switch(unsigned n, unsigned type)
 {
 	printf("\tld de,Sw%u\n", n);
-	printf("\tjp __switch");
-	helper_type(type, 0);
+	printf("\tjp ");
+	switch_helper(type);
 	printf("\n");
 	unreachable = 1;
 }
@@ -55,11 +55,14 @@ void invalidate_work(void)
 	d_valid = 0;
 }
 
-void invalidate_mem(void)
+/* Memory at the address n has been written */
+void invalidate_mem(struct node *n)
 {
 	/* If memory changes it might be an alias to the value cached in AB */
 	switch(d_node.op) {
 	case T_LREF:
+		if (!local_alias(n))
+			break;
 	case T_LBREF:
 	case T_NREF:
 		d_valid = 0;
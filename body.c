@@ -55,8 +55,10 @@ static void while_statement(void)
 	n = logic_expression(&t);
 
 	header(H_WHILE, cont_tag, t);
+	loop_depth++;
 	write_logic_tree(n, t);
 	statement_block(0);
+	loop_depth--;
 	footer(H_WHILE, cont_tag, t);
 
 	break_tag = oldbrk;
@@ -75,12 +77,14 @@ static void do_statement(void)
 
 	next_token();
 	header(H_DO, cont_tag, 0);
+	loop_depth++;
 	statement_block(0);
 	require(T_WHILE);
 	n = logic_expression(&t);
 	header(H_DOWHILE, cont_tag, t);
 	require(T_SEMICOLON);
 	write_logic_tree(n, t);
+	loop_depth--;
 	footer(H_DOWHILE, cont_tag, t);
 
 	break_tag = oldbrk;
@@ -101,11 +105,14 @@ static void for_statement(void)
 	require(T_LPAREN);
 	expression_or_null(0, NORETURN);
 	require(T_SEMICOLON);
+	/* The rest goes round with the body */
+	loop_depth++;
 	expression_or_null(1, CCONLY);
 	require(T_SEMICOLON);
 	expression_or_null(0, NORETURN);
 	require(T_RPAREN);
 	statement_block(0);
+	loop_depth--;
 	footer(H_FOR, cont_tag, break_tag);
 
 	break_tag = oldbrk;
@@ -114,9 +121,13 @@ static void for_statement(void)
 
 static void return_statement(void)
 {
+	unsigned long hpos;
+
 	next_token();
+	hpos = out_tell();
 	header(H_RETURN, func_tag, 0);
-	expression_typed(func_type);
+	if (expression_typed(func_type))
+		update_header(hpos, H_RETURN, func_tag, 1);
 	footer(H_RETURN, func_tag, 0);
 }
 
@@ -144,13 +155,17 @@ static void switch_statement(void)
 	unsigned oldswtype = switch_type;
 	unsigned olddefault = switch_default;
 	unsigned long *swptr;
+	unsigned long hpos;
 
 	switch_tag = next_tag++;
 	break_tag = next_tag++;
 	switch_count = 0;
+	switch_default = 0;
 
 	next_token();
-	header(H_SWITCH, switch_tag, break_tag);
+	/* switch_done fills in the table form once it has seen the cases */
+	hpos = out_tell();
+	header(H_SWITCH, switch_tag, H_SWITCHTAB);
 	switch_type = bracketed_expression(0);
 
 	/* Only integral types */
@@ -167,7 +182,7 @@ static void switch_statement(void)
 	if (!switch_default)
 		header(H_DEFAULT, switch_tag, 0);
 
-	switch_done(switch_tag, swptr, switch_type);
+	switch_done(switch_tag, swptr, switch_type, hpos);
 
 	switch_type = oldswtype;
 	break_tag = oldbrk;
@@ -374,7 +389,7 @@ void function_body(unsigned st, unsigned name, unsigned type)
 {
 	/* This makes me sad, but there isn't a nice way to work out
 	   the frame size ahead of time */
-	unsigned long hrw;
+	unsigned long hrw, hbody;
 	register unsigned *p;
 	register unsigned n;
 
@@ -395,6 +410,10 @@ void function_body(unsigned st, unsigned name, unsigned type)
 			break;
 		}
 	}
+	/* Until the body shows otherwise (see write_tree) */
+	func_flags |= F_NOADDR;
+	if (!(func_flags & F_VARARG))
+		func_flags |= F_LEAF;
 
 	if (st == S_AUTO || st == S_EXTERN)
 		error("invalid storage class");
@@ -403,17 +422,20 @@ void function_body(unsigned st, unsigned name, unsigned type)
 	header(H_ARGFRAME, func_argframe, 0);
 	hrw = mark_header();
 	header(H_FRAME, 0, 0);
+	hbody = out_tell();
 
 	/* Register arguments need loading into registers */
 	if (arg_flags)
 		load_registers();
 
 	init_labels();
+	init_regvars();
 
 	statement_block(1);
 
 	footer(H_FUNCTION, func_tag, name);
 
+	assign_regvars(hbody);
 	rewrite_header(hrw, H_FRAME, frame_size(), func_flags);
 	check_labels();
 }
@@ -8,6 +8,8 @@ extern unsigned func_argframe;
 #define F_VOIDRET		1
 #define F_VOID			2
 #define F_VARARG		4
+#define F_LEAF			8	/* No calls, no &local or &argument, not vararg */
+#define F_NOADDR		16	/* No &local or &argument */
 
 /* Registers start at 1 and bit 8 to 15 */
 #define F_REG(n)		(1 << (n + 7))
@@ -55,6 +55,14 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
+#include <sys/time.h>
+
+#include "host.h"
+
+#ifdef HOSTED
+#define HAVE_RUSAGE
+#include <sys/resource.h>
+#endif
 
 /*
  *	For all non native compilers the directories moved and the rules
@@ -252,6 +260,10 @@ const char *crtname = "crt0.o";
 
 int print_passes=0;
 int keep_temp;
+int jobs = 1;			/* Number of files to compile at once (-j) */
+int pipemode;			/* Connect the compiler passes with pipes */
+int nofused;			/* Run the passes even if there is a ccall */
+int treeopt;			/* Run the tree optimizer cc1b */
 int last_phase = 4;
 int only_one_input;
 char *target;
@@ -494,11 +506,231 @@ static void resolve_libraries(void)
 	}
 }
 
-static void run_command(void)
+/*
+ *	Pass timing (--time-report). A record is opened for each pass as it
+ *	is started and completed with the wall time and, where the host has
+ *	wait4(), the CPU time and peak memory use when it is reaped.
+ */
+
+struct timing {
+	pid_t pid;
+	const char *file;	/* Source file being worked on */
+	char pass[16];		/* Tool name without the path */
+	unsigned long wall;	/* Times are in microseconds */
+	unsigned long user;
+	unsigned long sys;
+	unsigned long maxrss;	/* Peak resident size in Kbytes */
+};
+
+int timereport;
+const char *timejson;		/* Also write the results here as JSON */
+const char *timefile = "";
+struct timing *timings;
+unsigned num_timings;
+static unsigned max_timings;
+
+static unsigned long time_now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000000UL + tv.tv_usec;
+}
+
+static struct timing *new_timing(void)
+{
+	if (num_timings == max_timings) {
+		max_timings += 64;
+		timings = realloc(timings, max_timings * sizeof(struct timing));
+		if (timings == NULL)
+			memory();
+	}
+	return timings + num_timings++;
+}
+
+static void timing_start(pid_t pid)
+{
+	struct timing *t = new_timing();
+	const char *p = strrchr(arglist[0], '/');
+
+	memset(t, 0, sizeof(struct timing));
+	t->pid = pid;
+	t->file = timefile;
+	strncpy(t->pass, p ? p + 1 : arglist[0], 15);
+	t->wall = time_now();
+}
+
+#ifdef HAVE_RUSAGE
+static void timing_end(pid_t pid, struct rusage *ru)
+#else
+static void timing_end(pid_t pid)
+#endif
+{
+	struct timing *t = timings + num_timings;
+	while (t-- > timings) {
+		if (t->pid == pid) {
+			t->pid = 0;
+			t->wall = time_now() - t->wall;
+#ifdef HAVE_RUSAGE
+			t->user = ru->ru_utime.tv_sec * 1000000UL + ru->ru_utime.tv_usec;
+			t->sys = ru->ru_stime.tv_sec * 1000000UL + ru->ru_stime.tv_usec;
+			t->maxrss = ru->ru_maxrss;
+#ifdef __APPLE__
+			t->maxrss /= 1024;
+#endif
+#endif
+			return;
+		}
+	}
+}
+
+static void print_time(FILE *f, unsigned long us)
+{
+	fprintf(f, " %6lu.%03lu", us / 1000000UL, (us / 1000) % 1000);
+}
+
+static void print_timing(FILE *f, const char *name, unsigned n, struct timing *t)
+{
+	fprintf(f, "%-24s", name);
+	if (n)
+		fprintf(f, " %5u", n);
+	else
+		fprintf(f, "      ");
+	print_time(f, t->wall);
+	print_time(f, t->user);
+	print_time(f, t->sys);
+	fprintf(f, " %8luK\n", t->maxrss);
+}
+
+static void json_string(FILE *f, const char *p)
+{
+	putc('"', f);
+	while (*p) {
+		if (*p == '"' || *p == '\\')
+			putc('\\', f);
+		if ((uint8_t)*p >= ' ')
+			putc(*p, f);
+		p++;
+	}
+	putc('"', f);
+}
+
+static void json_timing(FILE *f, struct timing *t)
+{
+	fprintf(f, "\"wall_us\": %lu, \"user_us\": %lu, \"sys_us\": %lu, \"max_rss_kb\": %lu }",
+		t->wall, t->user, t->sys, t->maxrss);
+}
+
+/* Sum up the records matching a pass or file. Returns the count */
+static unsigned sum_timing(struct timing *sum, const char *pass, const char *file)
 {
-	pid_t pid, p;
+	struct timing *t = timings;
+	unsigned n = 0;
+
+	memset(sum, 0, sizeof(struct timing));
+	while (t < timings + num_timings) {
+		if ((pass == NULL || strcmp(t->pass, pass) == 0) &&
+		    (file == NULL || strcmp(t->file, file) == 0)) {
+			sum->wall += t->wall;
+			sum->user += t->user;
+			sum->sys += t->sys;
+			if (t->maxrss > sum->maxrss)
+				sum->maxrss = t->maxrss;
+			n++;
+		}
+		t++;
+	}
+	return n;
+}
+
+/* Find if this is the first record for its pass (by == 0) or file */
+static unsigned first_timing(struct timing *t, unsigned by)
+{
+	struct timing *x = timings;
+	while (x < t) {
+		if (by == 0 && strcmp(x->pass, t->pass) == 0)
+			return 0;
+		if (by && strcmp(x->file, t->file) == 0)
+			return 0;
+		x++;
+	}
+	return 1;
+}
+
+static void timing_report(void)
+{
+	struct timing sum;
+	struct timing *t;
+	FILE *f;
+	unsigned n;
+	const char *sep = "";
+
+	fprintf(stderr, "\n%-24s  runs        wall        user         sys   max rss\n", "pass");
+	for (t = timings; t < timings + num_timings; t++) {
+		if (first_timing(t, 0)) {
+			n = sum_timing(&sum, t->pass, NULL);
+			print_timing(stderr, t->pass, n, &sum);
+		}
+	}
+	fprintf(stderr, "\n%-24s        %s\n", "file", "      wall        user         sys   max rss");
+	for (t = timings; t < timings + num_timings; t++) {
+		if (first_timing(t, 1)) {
+			sum_timing(&sum, NULL, t->file);
+			print_timing(stderr, t->file, 0, &sum);
+		}
+	}
+	n = sum_timing(&sum, NULL, NULL);
+	fputc('\n', stderr);
+	print_timing(stderr, "total", n, &sum);
+
+	if (timejson == NULL)
+		return;
+	f = fopen(timejson, "w");
+	if (f == NULL) {
+		perror(timejson);
+		return;
+	}
+	fprintf(f, "{\n  \"passes\": [");
+	for (t = timings; t < timings + num_timings; t++) {
+		if (first_timing(t, 0)) {
+			n = sum_timing(&sum, t->pass, NULL);
+			fprintf(f, "%s\n    { \"pass\": ", sep);
+			json_string(f, t->pass);
+			fprintf(f, ", \"runs\": %u, ", n);
+			json_timing(f, &sum);
+			sep = ",";
+		}
+	}
+	fprintf(f, "\n  ],\n  \"files\": [");
+	sep = "";
+	for (t = timings; t < timings + num_timings; t++) {
+		if (first_timing(t, 1)) {
+			sum_timing(&sum, NULL, t->file);
+			fprintf(f, "%s\n    { \"file\": ", sep);
+			json_string(f, t->file);
+			fprintf(f, ", ");
+			json_timing(f, &sum);
+			sep = ",";
+		}
+	}
+	fprintf(f, "\n  ],\n  \"runs\": [");
+	sep = "";
+	for (t = timings; t < timings + num_timings; t++) {
+		fprintf(f, "%s\n    { \"file\": ", sep);
+		json_string(f, t->file);
+		fprintf(f, ", \"pass\": ");
+		json_string(f, t->pass);
+		fprintf(f, ", ");
+		json_timing(f, t);
+		sep = ",";
+	}
+	fprintf(f, "\n  ]\n}\n");
+	fclose(f);
+}
+
+static pid_t start_command(void)
+{
+	pid_t pid;
 	const char **ptr;
-	int status;
 
 	fflush(stdout);
 
@@ -536,21 +768,47 @@ static void run_command(void)
 		close(arginfd);
 	if (argoutfd)
 		close(argoutfd);
+	if (timereport)
+		timing_start(pid);
+	return pid;
+}
+
+static int wait_command(pid_t pid, const char *name)
+{
+	pid_t p;
+	int status;
+#ifdef HAVE_RUSAGE
+	struct rusage ru;
+
+	while ((p = wait4(pid, &status, 0, &ru)) != pid) {
+#else
 	while ((p = waitpid(pid, &status, 0)) != pid) {
+#endif
 		if (p == -1) {
 			perror("waitpid");
 			fatal();
 		}
 	}
+	if (timereport)
+#ifdef HAVE_RUSAGE
+		timing_end(pid, &ru);
+#else
+		timing_end(pid);
+#endif
 	if (WIFSIGNALED(status)) {
 		/* Scream loudly if it exploded */
-		fprintf(stderr, "cc: %s failed with signal %d.\n", arglist[0],
+		fprintf(stderr, "cc: %s failed with signal %d.\n", name,
 			WTERMSIG(status));
-		fatal();
+		return 1;
 	}
 	/* Quietly exit if the stage errors. That means it has reported
 	   things to the user */
-	if (WEXITSTATUS(status))
+	return WEXITSTATUS(status);
+}
+
+static void run_command(void)
+{
+	if (wait_command(start_command(), arglist[0]))
 		fatal();
 }
 
@@ -600,13 +858,182 @@ void convert_s_to_o(char *path)
 	free(origpath);
 }
 
-void convert_c_to_s(char *path)
+/*
+ *	Set up a pipe between two passes. The ends are close on exec so that
+ *	only the pass we hand an end to holds it open, otherwise nobody ever
+ *	sees end of file.
+ */
+static void redirect_pipe(int *rfd)
+{
+	int pfd[2];
+	if (pipe(pfd) == -1) {
+		perror("pipe");
+		fatal();
+	}
+	fcntl(pfd[0], F_SETFD, FD_CLOEXEC);
+	fcntl(pfd[1], F_SETFD, FD_CLOEXEC);
+	argoutfd = pfd[1];
+	*rfd = pfd[0];
+#ifdef DEBUG
+	if (print_passes)
+		printf(">|\n");
+#endif
+}
+
+/* The tree optimizer cc1b runs between cc1 and cc2 when asked for */
+static int use_cc1b(void)
+{
+	return treeopt;
+}
+
+/*
+ *	Run cc0, cc1, cc1b, cc2 and copt at the same time joined by pipes so that
+ *	there are no scratch files between them. cc1 holds back each function
+ *	until it can fill in the frame header, and cc0 writes the symbol table
+ *	as it goes so cc2 can look names up early.
+ */
+static char *convert_c_to_s_pipe(char *path, char *featstr, char *optstr)
+{
+	const char *stage[5];
+	pid_t pid[5];
+	char *t, *p, *out;
+	int fd;
+	int n = 0;
+	int err = 0;
+
+	/* cc2 opens the table as it starts, it must exist by then */
+	fd = open(symtab, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if (fd == -1) {
+		perror(symtab);
+		fatal();
+	}
+	close(fd);
+
+	build_arglist(make_lib_name("cc0", ""));
+	add_argument(symtab);
+	t = xstrdup(path, 0);
+	redirect_in(pathmod(t, ".c", ".%", 0, 255));
+	redirect_pipe(&fd);
+	stage[n] = "cc0";
+	pid[n++] = start_command();
+
+	build_arglist(make_lib_name("cc1", cpudot));
+	add_argument(cpucode);
+	add_argument(featstr);
+	add_argument(optstr);
+	arginfd = fd;
+	redirect_pipe(&fd);
+	stage[n] = "cc1";
+	pid[n++] = start_command();
+
+	if (use_cc1b()) {
+		build_arglist(make_lib_name("cc1b", ""));
+		arginfd = fd;
+		redirect_pipe(&fd);
+		stage[n] = "cc1b";
+		pid[n++] = start_command();
+	}
+
+	build_arglist(make_lib_name("cc2", cpudot));
+	add_argument(symtab);
+	add_argument(cpucode);
+	add_argument(optstr);
+	add_argument(featstr);
+	if (codeseg)
+		add_argument(codeseg);
+	arginfd = fd;
+	out = pathmod(path, ".c", ".s", 2, 2);
+	if (optimize == '0')
+		redirect_out(out);
+	else
+		redirect_pipe(&fd);
+	stage[n] = "cc2";
+	pid[n++] = start_command();
+
+	if (optimize != '0') {
+		p = xstrdup(make_lib_name("copt", ""), 0);
+		build_arglist(p);
+		add_argument(make_lib_name("rules.", cpuset));
+		arginfd = fd;
+		redirect_out(out);
+		stage[n] = "copt";
+		pid[n++] = start_command();
+		free(p);
+	}
+	/* Collect them all before deciding, a failed pass will usually
+	   take the rest down with it */
+	while (n--)
+		err |= wait_command(pid[n], stage[n]);
+	free(t);
+	/* Don't leave a half written output behind */
+	if (err) {
+		unlink(out);
+		fatal();
+	}
+	return out;
+}
+
+/*
+ *	If we are a cross compiler and have a single process compiler for
+ *	this target (see fused.c) then use it and skip the scratch files and
+ *	process per pass. -X and --pipe want the separate passes.
+ */
+static char *convert_c_to_s_fused(char *path, char *fused, char *featstr, char *optstr)
+{
+	char *t, *out;
+
+	build_arglist(fused);
+	add_argument(cpucode);
+	add_argument(optstr);
+	add_argument(featstr);
+	add_argument(make_lib_name("rules.", cpuset));
+	if (codeseg)
+		add_argument(codeseg);
+	t = xstrdup(path, 0);
+	redirect_in(pathmod(t, ".c", ".%", 0, 255));
+	out = pathmod(path, ".c", ".s", 2, 2);
+	redirect_out(out);
+	if (wait_command(start_command(), fused)) {
+		unlink(out);
+		fatal();
+	}
+	free(t);
+	return out;
+}
+
+/* The single process compiler for this cpu if we have and want it */
+static char *fused_compiler(void)
+{
+	char *p;
+
+	if (native || keep_temp || nofused)
+		return NULL;
+	p = xstrdup(make_lib_name("ccall", cpudot), 0);
+	if (access(p, X_OK) == 0)
+		return p;
+	free(p);
+	return NULL;
+}
+
+static char *compile_c_to_s(char *path)
 {
-	char *tmp, *t, *p;
+	char *tmp, *t, *p, *out;
 	char optstr[2];
 	char featstr[16];
 
 	snprintf(featstr, 16, "%lu", features);
+	optstr[0] = optimize;
+	optstr[1] = '\0';
+
+	if (pipemode)
+		return convert_c_to_s_pipe(path, featstr, optstr);
+
+	p = fused_compiler();
+	if (p) {
+		out = convert_c_to_s_fused(path, p, featstr, optstr);
+		free(p);
+		return out;
+	}
 
 	build_arglist(make_lib_name("cc0", ""));
 	add_argument(symtab);
@@ -623,28 +1050,36 @@ void convert_c_to_s(char *path)
 	build_arglist(make_lib_name("cc1", cpudot));
 	add_argument(cpucode);
 	add_argument(featstr);
+	add_argument(optstr);
 	redirect_in(tmp);
 	tmp = pathmod(path, ".@", ".#", 0, 255);
 	redirect_out(tmp);
 	run_command();
 
+	if (use_cc1b()) {
+		build_arglist(make_lib_name("cc1b", ""));
+		redirect_in(tmp);
+		tmp = pathmod(path, ".#", ".!", 0, 255);
+		redirect_out(tmp);
+		run_command();
+	}
+
 	build_arglist(make_lib_name("cc2", cpudot));
 	add_argument(symtab);
 	add_argument(cpucode);
 	/* FIXME: need to change backend.c parsing for above and also
 	   add another arg when we do the new subcpu bits like -banked */
-	optstr[0] = optimize;
-	optstr[1] = '\0';
 	add_argument(optstr);
 	add_argument(featstr);
 	if (codeseg)
 		add_argument(codeseg);
 	redirect_in(tmp);
 	if (optimize == '0') {
-		redirect_out(pathmod(path, ".#", ".s", 2, 2));
+		out = pathmod(path, ".#", ".s", 2, 2);
+		redirect_out(out);
 		run_command();
 		free(t);
-		return;
+		return out;
 	}
 	tmp = pathmod(path, ".#", ".^", 0, 255);
 	redirect_out(tmp);
@@ -655,12 +1090,181 @@ void convert_c_to_s(char *path)
 	build_arglist(p);
 	add_argument(make_lib_name("rules.", cpuset));
 	redirect_in(tmp);
-	redirect_out(pathmod(path, ".#", ".s", 2, 2));
+	out = pathmod(path, ".#", ".s", 2, 2);
+	redirect_out(out);
 	run_command();
 	free(t);
 	free(p);
+	return out;
+}
+
+/*
+ *	Compile cache (--cache). The key is a hash of the preprocessed
+ *	source, everything we pass to the compiler passes and the size and
+ *	time of the pass binaries and rules, so a rebuilt compiler does not
+ *	reuse old output. A hit copies the stored assembler file into place
+ *	and skips cc0 through copt entirely.
+ *
+ *	The hash is a pair of 32bit hashes so that the driver can still be
+ *	built by compilers without a 64bit type.
+ */
+
+char *cachedir;
+unsigned cache_hits;
+unsigned cache_misses;
+
+static uint32_t cache_h1, cache_h2;
+
+static void hash_bytes(const void *pv, unsigned len)
+{
+	const uint8_t *p = pv;
+	while (len--) {
+		/* FNV-1a and a shifted xor variant of djb2 */
+		cache_h1 = (cache_h1 ^ *p) * 16777619UL;
+		cache_h2 = ((cache_h2 << 5) + cache_h2) ^ *p;
+		p++;
+	}
+}
+
+static void hash_string(const char *p)
+{
+	hash_bytes(p, strlen(p) + 1);
+}
+
+static void hash_tool(const char *path)
+{
+	struct stat st;
+	hash_string(path);
+	if (stat(path, &st) == 0) {
+		hash_bytes(&st.st_size, sizeof(st.st_size));
+		hash_bytes(&st.st_mtime, sizeof(st.st_mtime));
+	}
+}
+
+static int copy_file(const char *from, const char *to)
+{
+	static char buf[512];
+	int ifd, ofd;
+	int n;
+	int err = 0;
+
+	ifd = open(from, O_RDONLY);
+	if (ifd == -1)
+		return -1;
+	ofd = open(to, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (ofd == -1) {
+		close(ifd);
+		return -1;
+	}
+	while ((n = read(ifd, buf, 512)) > 0) {
+		if (write(ofd, buf, n) != n) {
+			err = -1;
+			break;
+		}
+	}
+	if (n < 0)
+		err = -1;
+	close(ifd);
+	if (close(ofd))
+		err = -1;
+	return err;
 }
 
+/* Work out the cache entry name for a preprocessed source */
+static char *cache_name(char *path)
+{
+	static char buf[512];
+	char *t = xstrdup(path, 0);
+	char *n, *f;
+	int fd;
+	int len;
+
+	cache_h1 = 2166136261UL;
+	cache_h2 = 5381;
+	fd = open(pathmod(t, ".c", ".%", 255, 255), O_RDONLY);
+	free(t);
+	if (fd == -1)
+		return NULL;
+	while ((len = read(fd, buf, 512)) > 0)
+		hash_bytes(buf, len);
+	close(fd);
+	if (len < 0)
+		return NULL;
+
+	hash_string(cpu);
+	hash_string(cpucode);
+	hash_bytes(&optimize, 1);
+	hash_bytes(&features, sizeof(features));
+	hash_bytes(&treeopt, sizeof(treeopt));
+	hash_string(codeseg ? codeseg : "");
+	/* Whichever compiler compile_c_to_s() is going to run */
+	f = pipemode ? NULL : fused_compiler();
+	if (f) {
+		hash_tool(f);
+		free(f);
+	} else {
+		hash_tool(make_lib_name("cc0", ""));
+		hash_tool(make_lib_name("cc1", cpudot));
+		if (use_cc1b())
+			hash_tool(make_lib_name("cc1b", ""));
+		hash_tool(make_lib_name("cc2", cpudot));
+		if (optimize != '0')
+			hash_tool(make_lib_name("copt", ""));
+	}
+	if (optimize != '0')
+		hash_tool(make_lib_name("rules.", cpuset));
+	n = malloc(strlen(cachedir) + 20);
+	if (n == NULL)
+		memory();
+	sprintf(n, "%s/%08lx%08lx.s", cachedir, (unsigned long)cache_h1,
+		(unsigned long)cache_h2);
+	return n;
+}
+
+void convert_c_to_s(char *path)
+{
+	char *t, *out, *ent = NULL;
+	char tmp[32];
+
+	if (cachedir)
+		ent = cache_name(path);
+	if (ent && access(ent, R_OK) == 0) {
+		/* Still have to clean up the preprocessor output */
+		t = xstrdup(path, 0);
+		pathmod(t, ".c", ".%", 0, 255);
+		free(t);
+		out = pathmod(path, ".c", ".s", 2, 2);
+#ifdef DEBUG
+		if (print_passes)
+			printf("[cache %s]\n>%s\n", ent, out);
+#endif
+		if (copy_file(ent, out) == 0) {
+			cache_hits++;
+			free(ent);
+			return;
+		}
+		/* A damaged entry, just compile it again */
+		unlink(ent);
+	}
+	out = compile_c_to_s(path);
+	if (ent) {
+		cache_misses++;
+		/* Write it under another name and rename so that two parallel
+		   builds never see a half written entry */
+		snprintf(tmp, 32, ".%lx", (unsigned long)getpid());
+		t = xstrdup(ent, strlen(tmp));
+		strcat(t, tmp);
+		if (copy_file(out, t) == 0)
+			rename(t, ent);
+		else
+			unlink(t);
+		free(t);
+		free(ent);
+	}
+}
+
+
+
 void convert_S_to_s(char *path)
 {
 	char *tmp;
@@ -700,6 +1304,7 @@ void link_phase(void)
 	/* Set the target as a.out if there is no target */
 	if (target==NULL)
 		target= "a.out";
+	timefile = target;
 
 	build_arglist(p);
 	switch (targetos) {
@@ -786,6 +1391,8 @@ void sequence(struct obj *i)
 {
 /*	printf("Last Phase %d\n", last_phase); */
 /*	printf("1:Processing %s %d\n", i->name, i->type); */
+	if (timereport)
+		timefile = xstrdup(i->name, 0);
 	if (i->type == TYPE_S) {
 		convert_S_to_s(i->name);
 		i->type = TYPE_s;
@@ -814,10 +1421,187 @@ void sequence(struct obj *i)
 	}
 }
 
+/*
+ *	Parallel job mode (-j). Each input file is run through its whole
+ *	sequence by a forked copy of ourself. The copy gets its own symbol
+ *	table file and sends everything it prints to a scratch log that we
+ *	replay in one piece when it finishes, so diagnostics for a file are
+ *	not interleaved with those of other files. The final name and type
+ *	of the object come back down a pipe so that the link phase sees the
+ *	same object list as a serial build.
+ */
+
+struct job {
+	pid_t pid;
+	struct obj *obj;
+	FILE *log;
+	int resfd;
+};
+
+static void run_job(struct obj *i, FILE *log, int resfd)
+{
+	uint8_t r[6];
+
+	snprintf(symtab + 7, 6, "%x", getpid());
+	cache_hits = 0;
+	cache_misses = 0;
+	num_timings = 0;
+	dup2(fileno(log), 1);
+	dup2(fileno(log), 2);
+	fclose(log);
+
+	sequence(i);
+	remove_temporaries();
+	if (keep_temp < 2)
+		unlink(symtab);
+
+	r[0] = i->type;
+	r[1] = i->used;
+	r[2] = cache_hits;
+	r[3] = cache_misses;
+	r[4] = num_timings;
+	r[5] = num_timings >> 8;
+	if (write(resfd, r, 6) != 6 ||
+	    write(resfd, timings, num_timings * sizeof(struct timing)) !=
+			num_timings * sizeof(struct timing) ||
+	    write(resfd, i->name, strlen(i->name)) != strlen(i->name))
+		exit(1);
+	fflush(stdout);
+	exit(0);
+}
+
+static void start_job(struct job *j, struct obj *i)
+{
+	int pfd[2];
+
+	j->obj = i;
+	j->log = tmpfile();
+	if (j->log == NULL) {
+		perror("tmpfile");
+		fatal();
+	}
+	if (pipe(pfd) == -1) {
+		perror("pipe");
+		fatal();
+	}
+	fflush(stdout);
+	fflush(stderr);
+	j->pid = fork();
+	if (j->pid == -1) {
+		perror("fork");
+		fatal();
+	}
+	if (j->pid == 0) {
+		close(pfd[0]);
+		run_job(i, j->log, pfd[1]);
+	}
+	close(pfd[1]);
+	j->resfd = pfd[0];
+}
+
+/* Report the output of a finished job and pick up the object it made */
+static int finish_job(struct job *j, int status)
+{
+	static char buf[CPATHSIZE + 1];
+	struct obj *i = j->obj;
+	struct timing *t;
+	uint8_t r[6];
+	unsigned n;
+	int c;
+	int len = 0;
+
+	fflush(stdout);
+	rewind(j->log);
+	while ((c = getc(j->log)) != EOF)
+		putc(c, stderr);
+	fclose(j->log);
+	j->pid = 0;
+
+	if (WIFSIGNALED(status)) {
+		fprintf(stderr, "cc: job for %s failed with signal %d.\n",
+			i->name, WTERMSIG(status));
+		close(j->resfd);
+		return 1;
+	}
+	if (WEXITSTATUS(status) || read(j->resfd, r, 6) != 6) {
+		close(j->resfd);
+		return 1;
+	}
+	/* The timing records all belong to this file */
+	n = r[4] | (r[5] << 8);
+	while (n--) {
+		t = new_timing();
+		if (read(j->resfd, t, sizeof(struct timing)) != sizeof(struct timing)) {
+			close(j->resfd);
+			return 1;
+		}
+		t->file = i->name;
+	}
+	while ((c = read(j->resfd, buf + len, CPATHSIZE - len)) > 0)
+		len += c;
+	close(j->resfd);
+	buf[len] = 0;
+	i->type = r[0];
+	i->used = r[1];
+	cache_hits += r[2];
+	cache_misses += r[3];
+	if (strcmp(i->name, buf))
+		i->name = xstrdup(buf, 0);
+	return 0;
+}
+
+static void parallel_loop(void)
+{
+	struct obj *i = objlist.head;
+	struct job *jt = calloc(jobs, sizeof(struct job));
+	struct job *j;
+	unsigned running = 0;
+	int failed = 0;
+	int status;
+	pid_t pid;
+
+	if (jt == NULL)
+		memory();
+	while (i || running) {
+		/* Keep the pool full unless something has gone wrong */
+		while (i && !failed && running < jobs) {
+			if (i->type != TYPE_O && i->type != TYPE_A) {
+				j = jt;
+				while (j->pid)
+					j++;
+				start_job(j, i);
+				running++;
+			}
+			i = i->next;
+		}
+		if (running == 0)
+			break;
+		pid = waitpid(-1, &status, 0);
+		if (pid == -1) {
+			perror("waitpid");
+			fatal();
+		}
+		for (j = jt; j < jt + jobs; j++) {
+			if (j->pid == pid) {
+				failed |= finish_job(j, status);
+				running--;
+				break;
+			}
+		}
+		if (failed)
+			i = NULL;
+	}
+	free(jt);
+	if (failed)
+		fatal();
+}
+
 void processing_loop(void)
 {
 	struct obj *i = objlist.head;
-	while (i) {
+	if (jobs > 1 && last_phase > 1)
+		parallel_loop();
+	else while (i) {
 		sequence(i);
 		remove_temporaries();
 		i = i->next;
@@ -940,12 +1724,67 @@ void uniopt(char *p)
 		usage();
 }
 
+/* The cache lives in $FCC_CACHE, or .fcc-cache in the home directory */
+void set_cache_dir(void)
+{
+	char *p = getenv("FCC_CACHE");
+	if (p == NULL) {
+		p = getenv("HOME");
+		if (p == NULL) {
+			fprintf(stderr, "cc: no cache directory.\n");
+			fatal();
+		}
+		cachedir = xstrdup(p, 11);
+		strcat(cachedir, "/.fcc-cache");
+	} else
+		cachedir = p;
+	if (mkdir(cachedir, 0777) == -1 && access(cachedir, W_OK) == -1) {
+		perror(cachedir);
+		fatal();
+	}
+}
+
 void extended_opt(const char *p)
 {
 	if (strcmp(p, "dlib") == 0) {
 		crtname = "lib0.o";
 		return;
 	}
+	if (strcmp(p, "pipe") == 0) {
+		pipemode = 1;
+		return;
+	}
+	if (strcmp(p, "no-fused") == 0) {
+		nofused = 1;
+		return;
+	}
+	if (strncmp(p, "time-report", 11) == 0) {
+		timereport = 1;
+		if (p[11] == '=')
+			timejson = p + 12;
+		else if (p[11])
+			usage();
+		return;
+	}
+	if (strcmp(p, "cache") == 0) {
+		set_cache_dir();
+		return;
+	}
+	/* Picked up by every copt we run, however we run it */
+	if (strncmp(p, "copt-profile=", 13) == 0) {
+		setenv("COPT_PROFILE", p + 13, 1);
+		return;
+	}
+	if (strcmp(p, "copt-stream") == 0) {
+		setenv("COPT_STREAM", "1", 1);
+		return;
+	}
+	/* ccall looks for CCALL_TREEOPT */
+	if (strcmp(p, "tree-opt") == 0) {
+		treeopt = 1;
+		setenv("CCALL_TREEOPT", "1", 1);
+		return;
+	}
 	usage();
 }
 
@@ -1015,6 +1854,16 @@ int main(int argc, char *argv[]) {
 		case 'D':
 			p = add_macro(p);
 			break;
+		case 'j':
+			if ((*p)[2])
+				jobs = atoi(*p + 2);
+			else if (p[1])
+				jobs = atoi(*++p);
+			if (jobs < 1) {
+				fprintf(stderr, "cc: invalid job count.\n");
+				fatal();
+			}
+			break;
 		case 'i':
 /*                    split_id();*/
 			uniopt(*p);
@@ -1115,6 +1964,10 @@ int main(int argc, char *argv[]) {
 	snprintf(symtab + 7, 6, "%x", getpid());
 	processing_loop();
 	unused_files();
+	if (cachedir && print_passes)
+		printf("cc: cache %u hits, %u misses.\n", cache_hits, cache_misses);
+	if (timereport)
+		timing_report();
 	if (keep_temp < 2)
 		unlink(symtab);
 	return 0;
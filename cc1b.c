@@ -0,0 +1,1536 @@
+/*
+ *	cc1b: optimize the trees from cc1
+ *
+ *	Reads the header, tree and data stream cc1 writes and writes the same
+ *	format back out for cc2. Anything outside a function is copied
+ *	straight through. Functions are loaded whole so that values can be
+ *	followed through the structure the headers describe, and then
+ *
+ *	- loads of a variable known to hold a constant, or a copy of another
+ *	  variable, are replaced by the constant or the other variable
+ *	  (constant and copy propagation), and constant expressions that
+ *	  result are folded
+ *	- an expression already held by a variable is replaced by a load of
+ *	  that variable (common subexpressions)
+ *	- stores to variables that are never read, or are overwritten before
+ *	  they are read, are removed (dead stores)
+ *	- registers whose variables that leaves unused are not saved
+ *
+ *	Only locals, arguments and register variables that are never
+ *	addressed and only ever accessed whole as integers or pointers are
+ *	tracked. Nothing but a direct assignment can then change them so calls
+ *	and stores through pointers can be ignored. A goto label anywhere in a
+ *	function, or a case label inside a loop within its switch, means we
+ *	can't trust the structure and we forget everything at each control
+ *	header instead.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "compiler.h"
+
+static const char *argv0;
+
+void error(const char *p)
+{
+	fprintf(stderr, "%s: error: %s\n", argv0, p);
+	exit(1);
+}
+
+/*
+ *	Buffered input and output as in cc2
+ */
+
+#define INBUF	512
+#define OUTBUF	512
+
+static uint8_t inbuf[INBUF];
+static uint8_t *inptr;
+static unsigned inlen;
+static uint8_t outbuf[OUTBUF];
+static unsigned outlen;
+
+static unsigned in_fill(void)
+{
+	int n = read(0, inbuf, INBUF);
+	if (n < 0)
+		error("read");
+	inptr = inbuf;
+	inlen = n;
+	return n;
+}
+
+/* Next byte of input or -1 for end of file */
+static int in_byte(void)
+{
+	if (inlen == 0 && in_fill() == 0)
+		return -1;
+	inlen--;
+	return *inptr++;
+}
+
+static void in_read(void *buf, unsigned len)
+{
+	uint8_t *p = buf;
+	unsigned n;
+	while (len) {
+		if (inlen == 0 && in_fill() == 0)
+			error("short read");
+		n = len;
+		if (n > inlen)
+			n = inlen;
+		memcpy(p, inptr, n);
+		inptr += n;
+		inlen -= n;
+		p += n;
+		len -= n;
+	}
+}
+
+static void obuf_flush(void)
+{
+	uint8_t *p = outbuf;
+	int n;
+	while (outlen) {
+		n = write(1, p, outlen);
+		if (n <= 0)
+			error("write");
+		p += n;
+		outlen -= n;
+	}
+}
+
+static void obuf_write(const void *buf, unsigned len)
+{
+	const uint8_t *p = buf;
+	unsigned n;
+	while (len) {
+		if (outlen == OUTBUF)
+			obuf_flush();
+		n = OUTBUF - outlen;
+		if (n > len)
+			n = len;
+		memcpy(outbuf + outlen, p, n);
+		outlen += n;
+		p += n;
+		len -= n;
+	}
+}
+
+/*
+ *	Everything belonging to a function comes from a pool that is thrown
+ *	away once it has been written out.
+ */
+
+#define POOL_SIZE	8192
+
+struct pool {
+	struct pool *next;
+	uint8_t *ptr;
+	uint8_t *end;
+};
+
+static struct pool *pools;
+
+static void *pool_alloc(unsigned len)
+{
+	struct pool *p = pools;
+	void *r;
+	unsigned size;
+
+	len = (len + 7) & ~7;
+	if (p == NULL || p->end - p->ptr < len) {
+		size = len > POOL_SIZE ? len : POOL_SIZE;
+		p = malloc(sizeof(struct pool) + size);
+		if (p == NULL)
+			error("out of memory");
+		p->ptr = (uint8_t *)(p + 1);
+		p->end = p->ptr + size;
+		p->next = pools;
+		pools = p;
+	}
+	r = p->ptr;
+	p->ptr += len;
+	return r;
+}
+
+/* Keep the oldest block for next time */
+static void pool_release(void)
+{
+	struct pool *p;
+	while ((p = pools) != NULL && p->next) {
+		pools = p->next;
+		free(p);
+	}
+	if (p)
+		p->ptr = (uint8_t *)(p + 1);
+}
+
+static struct node *node_alloc(void)
+{
+	struct node *n = pool_alloc(sizeof(struct node));
+	memset(n, 0, sizeof(struct node));
+	return n;
+}
+
+static struct node *copy_tree(struct node *n)
+{
+	struct node *c = node_alloc();
+	memcpy(c, n, sizeof(struct node));
+	if (n->left)
+		c->left = copy_tree(n->left);
+	if (n->right)
+		c->right = copy_tree(n->right);
+	return c;
+}
+
+/* The values off disk are old pointers or NULL, good enough as a flag */
+static struct node *load_tree(void)
+{
+	struct node *n = pool_alloc(sizeof(struct node));
+	in_read(n, sizeof(struct node));
+	if (n->left)
+		n->left = load_tree();
+	if (n->right)
+		n->right = load_tree();
+	return n;
+}
+
+static void put_tree(struct node *n)
+{
+	obuf_write(n, sizeof(struct node));
+	if (n->left)
+		put_tree(n->left);
+	if (n->right)
+		put_tree(n->right);
+}
+
+/*
+ *	The records of the function being worked on
+ */
+
+#define R_HEADER	0
+#define R_TREE		1
+#define R_DATA		2
+#define R_BYTES		3	/* String literal body */
+#define R_DROP		4	/* Tree we removed */
+
+struct record {
+	unsigned kind;
+	unsigned ctl;		/* Tree is part of the header before it */
+	struct header h;
+	struct node *n;
+	uint8_t *bytes;
+	unsigned len;
+};
+
+static struct record *rec;
+static unsigned nrec;
+static unsigned maxrec;
+static unsigned pending;	/* Trees still owed to the last header */
+
+static struct record *new_record(unsigned kind)
+{
+	struct record *r;
+	if (nrec == maxrec) {
+		maxrec = maxrec ? 2 * maxrec : 256;
+		rec = realloc(rec, maxrec * sizeof(struct record));
+		if (rec == NULL)
+			error("out of memory");
+	}
+	r = rec + nrec++;
+	memset(r, 0, sizeof(struct record));
+	r->kind = kind;
+	return r;
+}
+
+/* A literal is a run of bytes up to a 0, an internal 0 being quoted */
+static void load_literal(void)
+{
+	static uint8_t *buf;
+	static unsigned size;
+	unsigned len = 0;
+	struct record *r;
+	int c;
+
+	do {
+		c = in_byte();
+		if (c == -1)
+			error("unexpected EOF");
+		if (len == size) {
+			size = size ? 2 * size : 256;
+			buf = realloc(buf, size);
+			if (buf == NULL)
+				error("out of memory");
+		}
+		buf[len++] = c;
+	} while (c);
+	r = new_record(R_BYTES);
+	r->bytes = pool_alloc(len);
+	memcpy(r->bytes, buf, len);
+	r->len = len;
+}
+
+static void load_header(void)
+{
+	struct record *r = new_record(R_HEADER);
+	struct header *h = &r->h;
+
+	in_read(h, sizeof(struct header));
+	switch (h->h_type) {
+	case H_FOR:
+		pending = 3;
+		break;
+	case H_IF:
+	case H_WHILE:
+	case H_DOWHILE:
+		if (h->h_data == -1)
+			pending = 1;
+		break;
+	case H_SWITCH:
+		pending = 1;
+		break;
+	case H_STRING:
+		load_literal();
+		break;
+	}
+}
+
+static void write_records(void)
+{
+	struct record *r = rec;
+	struct record *e = rec + nrec;
+
+	while (r < e) {
+		switch (r->kind) {
+		case R_HEADER:
+			obuf_write("%H", 2);
+			obuf_write(&r->h, sizeof(struct header));
+			break;
+		case R_TREE:
+			obuf_write("%^", 2);
+			put_tree(r->n);
+			break;
+		case R_DATA:
+			obuf_write("%[", 2);
+			put_tree(r->n);
+			break;
+		case R_BYTES:
+			obuf_write(r->bytes, r->len);
+			break;
+		}
+		r++;
+	}
+	nrec = 0;
+	pool_release();
+}
+
+/*
+ *	Variables. A variable is a storage class, offset (or register), type
+ *	and name. Different variables can share storage (unions, the members
+ *	of a structure, block scopes reusing the frame) so each also knows
+ *	which others overlap it.
+ */
+
+#define CCFLAGS		(CCONLY | NEEDCC | CCFIXED)
+
+struct var {
+	struct node *tmpl;	/* A node naming it */
+	unsigned size;
+	unsigned escaped;
+	unsigned reads;
+	unsigned mark;
+	unsigned *alias;	/* Overlapping variables */
+	unsigned nalias;
+	int hnext;
+};
+
+#define VHASH	64
+
+static struct var *var;
+static unsigned nvar;
+static unsigned maxvar;
+static int vhash[VHASH];
+
+/* Same sizes as every target (see target_sizeof) */
+static unsigned sizetab[16] = {
+	1, 2, 4, 8,
+	1, 2, 4, 8,
+	4, 8, 0, 0,
+	0, 0, 0, 0
+};
+
+static unsigned type_size(unsigned t)
+{
+	if (PTR(t))
+		return 2;
+	if (!IS_SIMPLE(t))
+		return 0;
+	return sizetab[(t >> 4) & 0x0F];
+}
+
+/* Types we can follow */
+static unsigned trackable(unsigned t)
+{
+	return PTR(t) || t < CLONGLONG;
+}
+
+/* Integer types we can fold */
+static unsigned int_type(unsigned t)
+{
+	return !PTR(t) && t < CLONGLONG;
+}
+
+static unsigned is_var_node(struct node *n)
+{
+	return n->op == T_LOCAL || n->op == T_ARGUMENT || n->op == T_REG;
+}
+
+static unsigned is_rmw(unsigned op)
+{
+	switch (op) {
+	case T_PLUSPLUS:
+	case T_MINUSMINUS:
+	case T_PLUSEQ:
+	case T_MINUSEQ:
+	case T_STAREQ:
+	case T_SLASHEQ:
+	case T_PERCENTEQ:
+	case T_SHLEQ:
+	case T_SHREQ:
+	case T_ANDEQ:
+	case T_OREQ:
+	case T_HATEQ:
+		return 1;
+	}
+	return 0;
+}
+
+/* Operators we will remember the value of */
+static unsigned is_arith(unsigned op)
+{
+	switch (op) {
+	case T_PLUS:
+	case T_MINUS:
+	case T_STAR:
+	case T_SLASH:
+	case T_PERCENT:
+	case T_AND:
+	case T_OR:
+	case T_HAT:
+	case T_LTLT:
+	case T_GTGT:
+	case T_NEGATE:
+	case T_TILDE:
+	case T_CAST:
+		return 1;
+	}
+	return 0;
+}
+
+static unsigned var_hash(struct node *n)
+{
+	return (n->op ^ n->value ^ n->snum) & (VHASH - 1);
+}
+
+static int find_var(struct node *n)
+{
+	int i = vhash[var_hash(n)];
+	struct node *t;
+	while (i != -1) {
+		t = var[i].tmpl;
+		if (t->op == n->op && t->value == n->value &&
+		    t->type == n->type && t->snum == n->snum)
+			return i;
+		i = var[i].hnext;
+	}
+	return -1;
+}
+
+static void add_var(struct node *n)
+{
+	struct var *v;
+	unsigned h;
+
+	if (find_var(n) != -1)
+		return;
+	if (nvar == maxvar) {
+		maxvar = maxvar ? 2 * maxvar : 64;
+		var = realloc(var, maxvar * sizeof(struct var));
+		if (var == NULL)
+			error("out of memory");
+	}
+	h = var_hash(n);
+	v = var + nvar;
+	memset(v, 0, sizeof(struct var));
+	v->tmpl = n;
+	v->size = type_size(n->type);
+	v->hnext = vhash[h];
+	vhash[h] = nvar++;
+}
+
+/* Index of a variable we are following, or -1 */
+static int var_index(struct node *n)
+{
+	int i = find_var(n);
+	if (i == -1 || var[i].escaped)
+		return -1;
+	return i;
+}
+
+/* Variable a load reads, or -1 */
+static int load_var(struct node *n)
+{
+	if (n->op == T_DEREF && n->right && is_var_node(n->right))
+		return var_index(n->right);
+	return -1;
+}
+
+/* Variable a store or update writes, or -1 */
+static int store_var(struct node *n)
+{
+	if ((n->op == T_EQ || is_rmw(n->op)) && n->left && is_var_node(n->left))
+		return var_index(n->left);
+	return -1;
+}
+
+/*
+ *	Anything addressed or accessed in a way we don't follow escapes. As
+ *	structure members and array elements at constant offsets appear as
+ *	variables of their own we must also catch everything sharing the
+ *	name, and anything sharing the storage.
+ */
+
+struct escape {
+	unsigned op;
+	unsigned snum;
+	unsigned long lo;
+	unsigned long hi;
+};
+
+static struct escape *esc;
+static unsigned nesc;
+static unsigned maxesc;
+
+static void add_escape(struct node *n)
+{
+	struct escape *e;
+	if (nesc == maxesc) {
+		maxesc = maxesc ? 2 * maxesc : 16;
+		esc = realloc(esc, maxesc * sizeof(struct escape));
+		if (esc == NULL)
+			error("out of memory");
+	}
+	e = esc + nesc++;
+	e->op = n->op;
+	e->snum = n->snum;
+	e->lo = n->value;
+	e->hi = n->value + type_size(n->type);
+}
+
+static void note_access(struct node *n, unsigned type, unsigned flags)
+{
+	if ((n->flags & LVAL) && !((n->flags | flags) & SIDEEFFECT) &&
+	    n->type == type && trackable(type))
+		add_var(n);
+	else
+		add_escape(n);
+}
+
+static void scan_tree(struct node *n)
+{
+	struct node *l = n->left;
+	struct node *r = n->right;
+
+	if (n->op == T_DEREF && r && is_var_node(r)) {
+		/* A load used as an address is typed as what it points to */
+		note_access(r, n->type + !!(n->flags & LVAL), n->flags);
+		return;
+	}
+	if (l && is_var_node(l)) {
+		if (n->op == T_EQ) {
+			note_access(l, n->type, 0);
+			l = NULL;
+		} else if (is_rmw(n->op)) {
+			note_access(l, l->type, 0);
+			l = NULL;
+		}
+	}
+	if (is_var_node(n))
+		add_escape(n);
+	if (l)
+		scan_tree(l);
+	if (r)
+		scan_tree(r);
+}
+
+static unsigned overlap(struct node *a, unsigned asize, unsigned op,
+	unsigned long lo, unsigned long hi)
+{
+	return a->op == op && a->value < hi && lo < a->value + asize;
+}
+
+static void find_vars(void)
+{
+	struct record *r;
+	struct escape *e;
+	struct var *v, *w;
+	unsigned i, j;
+
+	nvar = 0;
+	nesc = 0;
+	for (i = 0; i < VHASH; i++)
+		vhash[i] = -1;
+	for (r = rec; r < rec + nrec; r++)
+		if (r->kind == R_TREE)
+			scan_tree(r->n);
+	for (v = var; v < var + nvar; v++) {
+		for (e = esc; e < esc + nesc; e++) {
+			if (v->tmpl->op == e->op && (v->tmpl->snum == e->snum ||
+			    overlap(v->tmpl, v->size, e->op, e->lo, e->hi))) {
+				v->escaped = 1;
+				break;
+			}
+		}
+	}
+	for (i = 0; i < nvar; i++) {
+		v = var + i;
+		for (j = 0; j < nvar; j++) {
+			w = var + j;
+			if (i != j && overlap(v->tmpl, v->size, w->tmpl->op,
+				w->tmpl->value, w->tmpl->value + w->size)) {
+				if (v->alias == NULL)
+					v->alias = pool_alloc(nvar * sizeof(unsigned));
+				v->alias[v->nalias++] = j;
+			}
+		}
+	}
+}
+
+/*
+ *	What we know: the value each variable holds, or NULL.
+ */
+
+static struct node **fact;
+static unsigned dead;		/* Can't get here */
+static unsigned stamp;
+static unsigned *mods;
+static unsigned nmods;
+
+static struct node dead_mark;
+
+static void forget(void)
+{
+	memset(fact, 0, nvar * sizeof(struct node *));
+	dead = 0;
+}
+
+static void unreachable(void)
+{
+	forget();
+	dead = 1;
+}
+
+static struct node **save_state(void)
+{
+	struct node **s = pool_alloc((nvar + 1) * sizeof(struct node *));
+	memcpy(s, fact, nvar * sizeof(struct node *));
+	s[nvar] = dead ? &dead_mark : NULL;
+	return s;
+}
+
+static void restore_state(struct node **s)
+{
+	memcpy(fact, s, nvar * sizeof(struct node *));
+	dead = s[nvar] != NULL;
+}
+
+static unsigned same_tree(struct node *a, struct node *b)
+{
+	if (a->op != b->op || a->type != b->type || a->value != b->value ||
+	    a->snum != b->snum || a->val2 != b->val2 ||
+	    ((a->flags ^ b->flags) & LVAL))
+		return 0;
+	if (!a->left != !b->left || !a->right != !b->right)
+		return 0;
+	if (a->left && !same_tree(a->left, b->left))
+		return 0;
+	if (a->right && !same_tree(a->right, b->right))
+		return 0;
+	return 1;
+}
+
+/* Join another path into this one */
+static void meet(struct node **s)
+{
+	unsigned i;
+	if (s[nvar])
+		return;
+	if (dead) {
+		restore_state(s);
+		return;
+	}
+	for (i = 0; i < nvar; i++)
+		if (fact[i] && (s[i] == NULL || !same_tree(fact[i], s[i])))
+			fact[i] = NULL;
+}
+
+static void mark_var(int v)
+{
+	if (v >= 0 && var[v].mark != stamp) {
+		var[v].mark = stamp;
+		mods[nmods++] = v;
+	}
+}
+
+static void find_mods(struct node *n)
+{
+	mark_var(store_var(n));
+	if (n->left)
+		find_mods(n->left);
+	if (n->right)
+		find_mods(n->right);
+}
+
+static unsigned uses_marked(struct node *n)
+{
+	int v = load_var(n);
+	if (v >= 0)
+		return var[v].mark == stamp;
+	if (n->left && uses_marked(n->left))
+		return 1;
+	if (n->right && uses_marked(n->right))
+		return 1;
+	return 0;
+}
+
+/* Mark everything sharing storage with the marked variables */
+static void mark_aliases(void)
+{
+	unsigned n = nmods;
+	unsigned i, j;
+	struct var *v;
+	for (i = 0; i < n; i++) {
+		v = var + mods[i];
+		for (j = 0; j < v->nalias; j++)
+			mark_var(v->alias[j]);
+	}
+}
+
+static void new_marks(void)
+{
+	stamp++;
+	nmods = 0;
+}
+
+/* Forget the marked variables and anything computed from them */
+static void kill_marked(void)
+{
+	unsigned i;
+	if (nmods == 0)
+		return;
+	mark_aliases();
+	for (i = 0; i < nvar; i++)
+		if (fact[i] && (var[i].mark == stamp || uses_marked(fact[i])))
+			fact[i] = NULL;
+}
+
+/*
+ *	Rewriting
+ */
+
+static struct node *make_load(int v, unsigned flags)
+{
+	struct node *n = node_alloc();
+	struct node *t = node_alloc();
+	struct node *p = var[v].tmpl;
+
+	t->op = p->op;
+	t->type = p->type;
+	t->value = p->value;
+	t->snum = p->snum;
+	t->flags = LVAL;
+	n->op = T_DEREF;
+	n->type = p->type;
+	n->flags = flags & ~(SIDEEFFECT | IMPURE);
+	n->right = t;
+	return n;
+}
+
+/* An expression with no side effects built only from things we follow */
+static unsigned pure_value(struct node *n)
+{
+	if (n->op == T_CONSTANT)
+		return 1;
+	if (load_var(n) >= 0)
+		return 1;
+	if (!is_arith(n->op) || !trackable(n->type) ||
+	    (n->flags & (SIDEEFFECT | CCFLAGS)))
+		return 0;
+	if (n->left && !pure_value(n->left))
+		return 0;
+	if (n->right && !pure_value(n->right))
+		return 0;
+	return 1;
+}
+
+/* Constants are kept sign extended from their size */
+static unsigned long sign_extend(unsigned t, unsigned long v)
+{
+	unsigned long m;
+	switch (t & 0x30) {
+	case CCHAR:
+		m = 0xFFUL;
+		break;
+	case CSHORT:
+		m = 0xFFFFUL;
+		break;
+	default:
+		m = 0xFFFFFFFFUL;
+		break;
+	}
+	v &= m;
+	if (!(t & UNSIGNED) && (v & ~(m >> 1)))
+		v |= ~m;
+	return v;
+}
+
+static struct node *fold(struct node *n)
+{
+	struct node *l = n->left;
+	struct node *r = n->right;
+	unsigned t = n->type;
+	unsigned long a = 0, b, v;
+	unsigned bits;
+
+	if (!is_arith(n->op) || !int_type(t) || (n->flags & CCFLAGS))
+		return n;
+	if (r == NULL || r->op != T_CONSTANT || !int_type(r->type))
+		return n;
+	b = sign_extend(r->type, r->value);
+	if (l) {
+		if (l->op != T_CONSTANT || !int_type(l->type))
+			return n;
+		a = sign_extend(l->type, l->value);
+	}
+	bits = 8 * sizetab[(t >> 4) & 0x0F];
+	switch (n->op) {
+	case T_NEGATE:
+		v = -b;
+		break;
+	case T_TILDE:
+		v = ~b;
+		break;
+	case T_CAST:
+		v = b;
+		break;
+	case T_PLUS:
+		v = a + b;
+		break;
+	case T_MINUS:
+		v = a - b;
+		break;
+	case T_STAR:
+		v = a * b;
+		break;
+	case T_AND:
+		v = a & b;
+		break;
+	case T_OR:
+		v = a | b;
+		break;
+	case T_HAT:
+		v = a ^ b;
+		break;
+	case T_LTLT:
+		if (b >= bits)
+			return n;
+		v = a << b;
+		break;
+	case T_GTGT:
+		if (b >= bits)
+			return n;
+		if (t & UNSIGNED)
+			v = a >> b;
+		else
+			v = (signed long)a >> b;
+		break;
+	case T_SLASH:
+	case T_PERCENT:
+		/* Leave division by zero for the program to find */
+		if (b == 0)
+			return n;
+		if (t & UNSIGNED)
+			v = n->op == T_SLASH ? a / b : a % b;
+		else if (b == ~0UL)
+			v = n->op == T_SLASH ? -a : 0;
+		else if (n->op == T_SLASH)
+			v = (signed long)a / (signed long)b;
+		else
+			v = (signed long)a % (signed long)b;
+		break;
+	default:
+		return n;
+	}
+	r = node_alloc();
+	r->op = T_CONSTANT;
+	r->type = t;
+	r->flags = n->flags & ~(SIDEEFFECT | IMPURE);
+	r->value = sign_extend(t, v);
+	return r;
+}
+
+/* Replace an expression some variable already holds */
+static struct node *common(struct node *n)
+{
+	unsigned i;
+	if (!is_arith(n->op) || (n->flags & CCFLAGS) || !pure_value(n))
+		return n;
+	for (i = 0; i < nvar; i++)
+		if (fact[i] && fact[i]->op == n->op && same_tree(fact[i], n))
+			return make_load(i, n->flags);
+	return n;
+}
+
+static struct node *rewrite(struct node *n)
+{
+	struct node *e;
+	int v = load_var(n);
+
+	if (v >= 0) {
+		e = fact[v];
+		if (e == NULL || (n->flags & LVAL))
+			return n;
+		if (e->op == T_CONSTANT) {
+			if (n->flags & CCFLAGS)
+				return n;
+		} else if (load_var(e) >= 0) {
+			/* Don't trade a register for memory */
+			if (var[v].tmpl->op == T_REG && e->right->op != T_REG)
+				return n;
+		} else
+			return n;
+		e = copy_tree(e);
+		e->flags = n->flags & ~(SIDEEFFECT | IMPURE);
+		return e;
+	}
+	if (n->left)
+		n->left = rewrite(n->left);
+	if (n->right)
+		n->right = rewrite(n->right);
+	return common(fold(n));
+}
+
+/* Remember what a store leaves in a variable */
+static void record_store(int v, struct node *r)
+{
+	struct node *t = var[v].tmpl;
+	int w;
+
+	if (r->type != t->type)
+		return;
+	if (r->op == T_CONSTANT) {
+		if (!int_type(r->type))
+			return;
+	} else if ((w = load_var(r)) >= 0) {
+		if (w == v)
+			return;
+	} else if (!is_arith(r->op) || !pure_value(r))
+		return;
+	new_marks();
+	mark_var(v);
+	mark_aliases();
+	if (!uses_marked(r))
+		fact[v] = copy_tree(r);
+}
+
+/*
+ *	An expression statement, or one belonging to a header. Anything
+ *	changed within it can't be trusted anywhere within it as we don't
+ *	know the order cc2 will evaluate it in, except that the right side
+ *	of an assignment happens before the store and a comma is ordered.
+ */
+static struct node *statement(struct node *n)
+{
+	int v = -1;
+
+	if (n->op == T_COMMA) {
+		n->left = statement(n->left);
+		n->right = statement(n->right);
+		return n;
+	}
+	new_marks();
+	if (n->op == T_EQ && (v = store_var(n)) >= 0)
+		find_mods(n->right);
+	else
+		find_mods(n);
+	kill_marked();
+	n = rewrite(n);
+	if (v >= 0) {
+		new_marks();
+		mark_var(v);
+		kill_marked();
+		if (!dead)
+			record_store(v, n->right);
+	}
+	return n;
+}
+
+/*
+ *	Following the structure
+ */
+
+struct ctx {
+	unsigned type;
+	unsigned tag;
+	unsigned start;
+	unsigned end;
+	struct node **top;	/* Condition, top of loop, or switch dispatch */
+	struct node **other;	/* End of if part, or end of switch */
+};
+
+static struct ctx *ctx;
+static unsigned nctx;
+static unsigned maxctx;
+static struct ctx last_switch;
+static unsigned unstructured;
+
+static struct ctx *push_ctx(unsigned i)
+{
+	struct ctx *c;
+	if (nctx == maxctx) {
+		maxctx = maxctx ? 2 * maxctx : 16;
+		ctx = realloc(ctx, maxctx * sizeof(struct ctx));
+		if (ctx == NULL)
+			error("out of memory");
+	}
+	c = ctx + nctx++;
+	memset(c, 0, sizeof(struct ctx));
+	c->type = rec[i].h.h_type;
+	c->tag = rec[i].h.h_name;
+	c->start = i;
+	return c;
+}
+
+static struct ctx *pop_ctx(unsigned tag)
+{
+	if (nctx == 0 || ctx[nctx - 1].tag != tag)
+		error("bad nesting");
+	return ctx + --nctx;
+}
+
+static unsigned is_loop(unsigned t)
+{
+	return t == H_FOR || t == H_WHILE || t == H_DO;
+}
+
+/* Work out if we can follow the structure of the function */
+static void check_structure(void)
+{
+	struct record *r;
+	unsigned t;
+	int i;
+
+	unstructured = 0;
+	nctx = 0;
+	for (r = rec; r < rec + nrec; r++) {
+		if (r->kind != R_HEADER)
+			continue;
+		t = r->h.h_type;
+		switch (t) {
+		case H_LABEL:
+		case H_GOTO:
+			unstructured = 1;
+			break;
+		case H_FOR:
+		case H_WHILE:
+		case H_DO:
+		case H_SWITCH:
+			push_ctx(r - rec);
+			break;
+		case H_FOR | H_FOOTER:
+		case H_WHILE | H_FOOTER:
+		case H_DOWHILE | H_FOOTER:
+		case H_SWITCH | H_FOOTER:
+			pop_ctx(r->h.h_name);
+			break;
+		case H_CASE:
+		case H_DEFAULT:
+			for (i = nctx - 1; i >= 0; i--) {
+				if (ctx[i].type == H_SWITCH &&
+				    ctx[i].tag == r->h.h_name)
+					break;
+				if (is_loop(ctx[i].type))
+					unstructured = 1;
+			}
+			break;
+		}
+	}
+	nctx = 0;
+}
+
+static unsigned next_tree(unsigned i)
+{
+	while (++i < nrec)
+		if (rec[i].kind == R_TREE)
+			return i;
+	error("missing tree");
+	return 0;
+}
+
+static void do_tree(unsigned i)
+{
+	rec[i].n = statement(rec[i].n);
+}
+
+static unsigned find_header(unsigned i, unsigned type, unsigned tag)
+{
+	while (++i < nrec)
+		if (rec[i].kind == R_HEADER && rec[i].h.h_type == type &&
+		    rec[i].h.h_name == tag)
+			return i;
+	error("missing footer");
+	return 0;
+}
+
+/* Is there a jump of this type and tag between the records */
+static unsigned find_jump(unsigned i, unsigned end, unsigned type, unsigned tag)
+{
+	while (++i < end)
+		if (rec[i].kind == R_HEADER && rec[i].h.h_type == type &&
+		    rec[i].h.h_name == tag)
+			return 1;
+	return 0;
+}
+
+/* Forget anything changed between the records */
+static void kill_region(unsigned i, unsigned end)
+{
+	new_marks();
+	while (++i < end)
+		if (rec[i].kind == R_TREE)
+			find_mods(rec[i].n);
+	kill_marked();
+	if (dead)
+		forget();
+}
+
+static void control(unsigned i)
+{
+	struct header *h = &rec[i].h;
+	struct ctx *c;
+	struct node **s;
+	unsigned t1, t2;
+	int n;
+
+	switch (h->h_type) {
+	case H_IF:
+		if (h->h_data == -1)
+			do_tree(next_tree(i));
+		c = push_ctx(i);
+		c->top = save_state();
+		break;
+	case H_ELSE:
+		c = ctx + nctx - 1;
+		c->other = save_state();
+		restore_state(c->top);
+		break;
+	case H_IF | H_FOOTER:
+		c = pop_ctx(h->h_name);
+		meet(h->h_data ? c->other : c->top);
+		break;
+	/* Only what isn't changed anywhere in a loop survives into it, and
+	   that is also all we know when we leave */
+	case H_WHILE:
+		c = push_ctx(i);
+		c->end = find_header(i, H_WHILE | H_FOOTER, h->h_name);
+		kill_region(i, c->end);
+		c->top = save_state();
+		if (h->h_data == -1)
+			do_tree(next_tree(i));
+		break;
+	case H_FOR:
+		t1 = next_tree(i);
+		do_tree(t1);
+		c = push_ctx(i);
+		c->end = find_header(i, H_FOR | H_FOOTER, h->h_name);
+		kill_region(t1, c->end);
+		c->top = save_state();
+		t2 = next_tree(t1);
+		do_tree(t2);
+		s = save_state();
+		restore_state(c->top);
+		do_tree(next_tree(t2));
+		restore_state(s);
+		break;
+	case H_WHILE | H_FOOTER:
+	case H_FOR | H_FOOTER:
+		c = pop_ctx(h->h_name);
+		restore_state(c->top);
+		break;
+	case H_DO:
+		c = push_ctx(i);
+		c->end = find_header(i, H_DOWHILE | H_FOOTER, h->h_name);
+		kill_region(i, c->end);
+		c->top = save_state();
+		break;
+	case H_DOWHILE:
+		c = ctx + nctx - 1;
+		if (find_jump(c->start, i, H_CONTINUE, h->h_name))
+			meet(c->top);
+		if (h->h_data == -1)
+			do_tree(next_tree(i));
+		break;
+	case H_DOWHILE | H_FOOTER:
+		c = pop_ctx(h->h_name);
+		if (find_jump(c->start, i, H_BREAK, h->h_name))
+			restore_state(c->top);
+		break;
+	/* Each case joins the dispatch with the case above falling through */
+	case H_SWITCH:
+		do_tree(next_tree(i));
+		c = push_ctx(i);
+		c->end = find_header(i, H_SWITCH | H_FOOTER, h->h_name);
+		c->top = save_state();
+		kill_region(i, c->end);
+		c->other = save_state();
+		unreachable();
+		break;
+	case H_CASE:
+	case H_DEFAULT:
+		for (n = nctx - 1; n >= 0; n--)
+			if (ctx[n].type == H_SWITCH && ctx[n].tag == h->h_name)
+				break;
+		if (n >= 0)
+			meet(ctx[n].top);
+		else if (last_switch.tag == h->h_name && last_switch.top)
+			meet(last_switch.top);
+		else
+			forget();
+		break;
+	case H_SWITCH | H_FOOTER:
+		c = pop_ctx(h->h_name);
+		restore_state(c->other);
+		last_switch = *c;
+		break;
+	case H_BREAK:
+	case H_CONTINUE:
+	case H_GOTO:
+	case H_RETURN | H_FOOTER:
+		unreachable();
+		break;
+	case H_LABEL:
+		forget();
+		break;
+	}
+}
+
+/* Headers that don't change the flow */
+static unsigned is_inline_header(unsigned t)
+{
+	switch (t & ~H_FOOTER) {
+	case H_STRING:
+	case H_DATA:
+	case H_BSS:
+	case H_EXPORT:
+	case H_FRAME:
+	case H_ARGFRAME:
+	case H_FUNCTION:
+		return 1;
+	}
+	return 0;
+}
+
+static void propagate(void)
+{
+	struct record *r;
+	unsigned i;
+
+	fact = pool_alloc((nvar + 1) * sizeof(struct node *));
+	mods = pool_alloc((nvar + 1) * sizeof(unsigned));
+	forget();
+	nctx = 0;
+	last_switch.top = NULL;
+	for (i = 0; i < nrec; i++) {
+		r = rec + i;
+		if (unstructured) {
+			/* Labels can be anywhere a header is */
+			if (r->kind == R_TREE) {
+				if (r->ctl)
+					forget();
+				do_tree(i);
+				if (r->ctl)
+					forget();
+			} else if (r->kind == R_HEADER && !is_inline_header(r->h.h_type))
+				forget();
+		} else if (r->kind == R_TREE && !r->ctl)
+			do_tree(i);
+		else if (r->kind == R_HEADER)
+			control(i);
+	}
+}
+
+/*
+ *	Dead stores
+ */
+
+static unsigned removed;
+
+static void count_reads(struct node *n)
+{
+	int v = load_var(n);
+	if (v < 0)
+		v = store_var(n);
+	if (v >= 0 && n->op != T_EQ)
+		var[v].reads++;
+	if (n->left)
+		count_reads(n->left);
+	if (n->right)
+		count_reads(n->right);
+}
+
+static unsigned is_live(int v)
+{
+	struct var *p = var + v;
+	unsigned i;
+	if (p->reads)
+		return 1;
+	for (i = 0; i < p->nalias; i++)
+		if (var[p->alias[i]].reads)
+			return 1;
+	return 0;
+}
+
+static unsigned no_effect(struct node *n)
+{
+	if ((n->flags & SIDEEFFECT) || n->op == T_FUNCCALL)
+		return 0;
+	if (n->left && !no_effect(n->left))
+		return 0;
+	if (n->right && !no_effect(n->right))
+		return 0;
+	return 1;
+}
+
+/* An expression whose value is needed */
+static struct node *keep(struct node *n)
+{
+	struct node *r;
+	int v;
+
+	if (n->left)
+		n->left = keep(n->left);
+	if (n->right)
+		n->right = keep(n->right);
+	r = n->right;
+	if (n->op == T_EQ && (v = store_var(n)) >= 0 && !is_live(v) &&
+	    !(n->flags & CCFLAGS) && r->type == n->type) {
+		r->flags |= n->flags & NORETURN;
+		removed++;
+		return r;
+	}
+	return n;
+}
+
+/* An expression whose value isn't needed, NULL if nothing is left */
+static struct node *discard(struct node *n)
+{
+	struct node *l, *r;
+	int v;
+
+	if (n->op == T_EQ && (v = store_var(n)) >= 0 &&
+	    (!is_live(v) || load_var(n->right) == v)) {
+		removed++;
+		return discard(n->right);
+	}
+	if (n->op == T_COMMA) {
+		l = discard(n->left);
+		r = discard(n->right);
+		if (l == NULL)
+			return r;
+		if (r == NULL)
+			return l;
+		n->left = l;
+		n->right = r;
+		return n;
+	}
+	if (no_effect(n))
+		return NULL;
+	n = keep(n);
+	n->flags |= NORETURN;
+	return n;
+}
+
+static unsigned reads_marked(struct node *n)
+{
+	int v = load_var(n);
+	if (v < 0 && is_rmw(n->op))
+		v = store_var(n);
+	if (v >= 0 && var[v].mark == stamp)
+		return 1;
+	if (n->left && reads_marked(n->left))
+		return 1;
+	if (n->right && reads_marked(n->right))
+		return 1;
+	return 0;
+}
+
+static struct node *null_tree(void)
+{
+	struct node *n = node_alloc();
+	n->op = T_NULL;
+	n->type = VOID;
+	return n;
+}
+
+static void trim_tree(struct record *r, struct node *n)
+{
+	if (n)
+		r->n = n;
+	else if (r->ctl)
+		r->n = null_tree();
+	else
+		r->kind = R_DROP;
+}
+
+/* A store overwritten before anything reads it */
+static unsigned overwritten(unsigned i)
+{
+	struct node *n = rec[i].n;
+	struct record *r;
+	int v;
+
+	if (n->op != T_EQ || !(n->flags & NORETURN) || (v = store_var(n)) < 0)
+		return 0;
+	new_marks();
+	mark_var(v);
+	mark_aliases();
+	while (++i < nrec) {
+		r = rec + i;
+		if (r->kind == R_HEADER) {
+			if (!is_inline_header(r->h.h_type))
+				return 0;
+			continue;
+		}
+		if (r->kind != R_TREE)
+			continue;
+		if (r->ctl || reads_marked(r->n))
+			return 0;
+		if (r->n->op == T_EQ && store_var(r->n) == v)
+			return 1;
+	}
+	return 0;
+}
+
+static void dead_stores(void)
+{
+	struct record *r;
+	struct var *v;
+	unsigned i;
+	unsigned pass = 0;
+
+	do {
+		removed = 0;
+		for (v = var; v < var + nvar; v++)
+			v->reads = 0;
+		for (r = rec; r < rec + nrec; r++)
+			if (r->kind == R_TREE)
+				count_reads(r->n);
+		for (i = 0; i < nrec; i++) {
+			r = rec + i;
+			if (r->kind != R_TREE)
+				continue;
+			if (!r->ctl && overwritten(i)) {
+				removed++;
+				trim_tree(r, discard(r->n->right));
+			} else if (r->n->flags & NORETURN)
+				trim_tree(r, discard(r->n));
+			else
+				r->n = keep(r->n);
+		}
+	} while (removed && ++pass < 4);
+}
+
+static unsigned regs_used(struct node *n)
+{
+	unsigned r = 0;
+	if (n->op == T_REG)
+		r = F_REG(n->value);
+	if (n->left)
+		r |= regs_used(n->left);
+	if (n->right)
+		r |= regs_used(n->right);
+	return r;
+}
+
+/* A register whose variable we did away with need not be saved */
+static void unused_registers(void)
+{
+	struct record *r;
+	unsigned used = 0;
+
+	for (r = rec; r < rec + nrec; r++)
+		if (r->kind == R_TREE)
+			used |= regs_used(r->n);
+	for (r = rec; r < rec + nrec; r++)
+		if (r->kind == R_HEADER && r->h.h_type == H_FRAME)
+			r->h.h_data &= ~F_REGMASK | used;
+}
+
+static void optimize_function(void)
+{
+	find_vars();
+	if (nvar == 0)
+		return;
+	check_structure();
+	propagate();
+	dead_stores();
+	unused_registers();
+}
+
+int main(int argc, char *argv[])
+{
+	uint8_t h[2];
+	unsigned infunc = 0;
+	struct record *r;
+	int c;
+
+	argv0 = argv[0];
+	if (argc != 1)
+		error("arguments");
+
+	while ((c = in_byte()) != -1) {
+		h[0] = c;
+		in_read(h + 1, 1);
+		if (h[0] != '%')
+			error("sync");
+		if (h[1] == 'H') {
+			load_header();
+			r = rec + nrec - 1;
+			if (r->kind != R_HEADER)
+				r--;
+			if (r->h.h_type == H_FUNCTION)
+				infunc = 1;
+			else if (r->h.h_type == (H_FUNCTION | H_FOOTER)) {
+				optimize_function();
+				infunc = 0;
+			}
+		} else if (h[1] == '^' || h[1] == '[') {
+			r = new_record(h[1] == '^' ? R_TREE : R_DATA);
+			r->n = load_tree();
+			if (r->kind == R_TREE && pending) {
+				r->ctl = 1;
+				pending--;
+			}
+		} else
+			error("unknown block");
+		if (!infunc)
+			write_records();
+	}
+	obuf_flush();
+	return 0;
+}
@@ -1,3 +1,4 @@
+#include "host.h"
 
 /* Pass 2 values */
 
@@ -8,6 +9,10 @@
 /* Expression nodes. Currently 16 bytes on a small box will be about 24 once
    we have everything in */
 #define NUM_NODES		100
+/* Hosted builds add further slabs of NUM_NODES nodes when they run out */
+#ifdef HOSTED
+#define NODE_SLABS
+#endif
 /* Number of bytees of index data used for tagging structs, prototypes etc */
 #define IDX_SIZE		1536
 /* Maximum number of goto labels per function (not switches), 4 bytes each */
@@ -21,6 +26,15 @@
 #define NUM_CONSTANT		50
 /* Number of non local volatiles */
 #define NUM_VOLATILE		8
+/* Locals and arguments per function followed for automatic register
+   variables (20 bytes each) and uses of them we can rewrite (5 bytes) */
+#ifdef HOSTED
+#define NUM_REGVAR		128
+#define NUM_REGUSE		2048
+#else
+#define NUM_REGVAR		24
+#define NUM_REGUSE		128
+#endif
 
 #include <stdio.h>
 
@@ -53,3 +67,4 @@ extern FILE *debug;
 extern unsigned in_sizeof;
 extern unsigned cputype;
 extern unsigned long cpufeat;
+extern unsigned optlevel;
@@ -6,10 +6,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 int rpn_eval(const char* expr, char** vars);
 
-#define HSIZE 107
+#define HSIZE 128 /* initial, doubles as it fills */
+#define ARENA_SIZE 4096
+#define LCHUNK 128
+#define RHASH 128
 #define MAXLINE 128
 #define MAXFIRECOUNT 65535L
 #define MAX_PASS 16
@@ -27,12 +33,41 @@ struct lnode {
     struct lnode *l_prev, *l_next;
 };
 
+/* Profile counts for a rule in a rules file. Rules made by %activate
+   count towards the rule that activated them */
+struct rstat {
+    char* r_key; /* file:line */
+    char* r_text; /* last pattern line */
+    unsigned long r_tries, r_fires, r_removed, r_added, r_nsec;
+    struct rstat* r_next;
+}* rstats = 0;
+
 struct onode {
     struct lnode *o_old, *o_new;
     struct onode* o_next;
     long firecount;
+    struct onode* o_hnext; /* next rule with the same key */
+    unsigned o_seq; /* position in opts */
+    struct rstat* o_stat;
 }* opts = 0, *activerule = 0;
 
+/* Distinct pattern lines by key, for spotting lines no rule can match */
+struct pnode {
+    char* p_text;
+    struct pnode* p_next;
+}* phash[RHASH], *pwild;
+
+char* profile; /* profile report file from COPT_PROFILE */
+int lineno; /* line in the rules file being read */
+int rule_line; /* line the current rule starts on */
+
+/* Rules indexed by the mnemonic their last pattern line starts with.
+   Rules where that isn't fixed text are on the wild list and are
+   tried for every line */
+struct onode* rhash[RHASH];
+struct onode* rwild;
+int rindex_dirty = 1;
+
 void printlines(struct lnode* beg, struct lnode* end, FILE* out)
 {
     struct lnode* p;
@@ -70,47 +105,128 @@ void connect(struct lnode* p1, struct lnode* p2)
     p2->l_prev = p1;
 }
 
+/*
+ *	Interned strings and their table nodes live until we exit so they
+ *	are carved out of big blocks. Line nodes come and go as rules fire so
+ *	they are allocated in chunks and recycled through a free list.
+ */
+char* arena_ptr;
+unsigned arena_left;
+
+/* arena - allocate n bytes that are never freed */
+void* arena(unsigned n)
+{
+    void* p;
+    n = (n + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+    if (n > arena_left) {
+        arena_left = n > ARENA_SIZE ? n : ARENA_SIZE;
+        arena_ptr = (char*)malloc(arena_left);
+        if (arena_ptr == NULL)
+            error("arena: out of memory\n");
+    }
+    p = arena_ptr;
+    arena_ptr += n;
+    arena_left -= n;
+    return p;
+}
+
+struct hnode {
+    struct hnode* h_ptr;
+    unsigned h_hash;
+    char h_str[1];
+};
+
+struct hnode** htab;
+unsigned hsize, hcount;
+
+/* grow_table - double the string table and rehash. If there isn't the
+   memory we just carry on with longer chains */
+void grow_table(void)
+{
+    struct hnode **t, *p, *n;
+    unsigned size = hsize ? hsize * 2 : HSIZE;
+    unsigned i;
+
+    t = (struct hnode**)calloc(size, sizeof(struct hnode*));
+    if (t == NULL) {
+        if (hsize)
+            return;
+        error("install: out of memory\n");
+    }
+    for (i = 0; i < hsize; i++) {
+        for (p = htab[i]; p; p = n) {
+            n = p->h_ptr;
+            p->h_ptr = t[p->h_hash & (size - 1)];
+            t[p->h_hash & (size - 1)] = p;
+        }
+    }
+    free(htab);
+    htab = t;
+    hsize = size;
+}
+
 /* install - install str in string table */
 char* install(char* str)
 {
     register struct hnode* p;
-    register char *p1, *p2, *s;
-    register int i;
-    static struct hnode {
-        char* h_str;
-        struct hnode* h_ptr;
-    } * htab[HSIZE] = { 0 };
-
-    s = str;
-    for (i = 0; *s; i += *s++)
-        ;
-    i = abs(i) % HSIZE;
-
-    for (p = htab[i]; p; p = p->h_ptr)
-        for (p1 = str, p2 = p->h_str; *p1++ == *p2++;)
-            if (p1[-1] == '\0')
-                return (p->h_str);
-
-    p = (struct hnode*)malloc(sizeof *p);
-    if (p == NULL)
-        error("install 1: out of memory\n");
-    p->h_str = (char*)malloc((s - str) + 1);
-    if (p->h_str == NULL)
-        error("install 2: out of memory\n");
-    strcpy(p->h_str, str);
-    p->h_ptr = htab[i];
-    htab[i] = p;
+    register char* s;
+    register unsigned h = 5381;
+
+    /* djb2 (xor form) as it needs no multiply on small machines */
+    for (s = str; *s; s++)
+        h = ((h << 5) + h) ^ (unsigned char)*s;
+
+    if (hcount >= hsize)
+        grow_table();
+
+    for (p = htab[h & (hsize - 1)]; p; p = p->h_ptr)
+        if (p->h_hash == h && strcmp(p->h_str, str) == 0)
+            return (p->h_str);
+
+    p = (struct hnode*)arena(sizeof(struct hnode) + (s - str));
+    memcpy(p->h_str, str, (s - str) + 1);
+    p->h_hash = h;
+    p->h_ptr = htab[h & (hsize - 1)];
+    htab[h & (hsize - 1)] = p;
+    hcount++;
     return (p->h_str);
 }
 
+struct lnode* lfree;
+
+/* new_lnode - take a line node off the free list */
+struct lnode* new_lnode(void)
+{
+    struct lnode* n;
+    int i;
+
+    if (lfree == NULL) {
+        n = (struct lnode*)malloc(LCHUNK * sizeof(struct lnode));
+        if (n == NULL)
+            error("insert: out of memory\n");
+        for (i = 0; i < LCHUNK; i++) {
+            n->l_next = lfree;
+            lfree = n++;
+        }
+    }
+    n = lfree;
+    lfree = n->l_next;
+    return n;
+}
+
+/* free_lnode - put a line node back on the free list */
+void free_lnode(struct lnode* n)
+{
+    n->l_next = lfree;
+    lfree = n;
+}
+
 /* insert - insert a new node with text s before node p */
 void insert(char* s, struct lnode* p)
 {
     struct lnode* n;
 
-    n = (struct lnode*)malloc(sizeof *n);
-    if (n == NULL)
-        error("insert: out of memory\n");
+    n = new_lnode();
     n->l_text = s;
     connect(p->l_prev, n);
     connect(n, p);
@@ -122,7 +238,10 @@ void getlst(FILE* fp, char* quit, struct lnode* p1, struct lnode* p2)
     char lin[MAXLINE];
 
     connect(p1, p2);
-    while (fgets(lin, MAXLINE, fp) != NULL && strcmp(lin, quit)) {
+    while (fgets(lin, MAXLINE, fp) != NULL) {
+        lineno++;
+        if (strcmp(lin, quit) == 0)
+            break;
         insert(install(lin), p2);
     }
 }
@@ -135,7 +254,10 @@ void getlst_1(FILE* fp, char* quit, struct lnode* p1, struct lnode* p2)
     int firstline = 1;
 
     connect(p1, p2);
-    while (fgets(lin, MAXLINE, fp) != NULL && strcmp(lin, quit)) {
+    while (fgets(lin, MAXLINE, fp) != NULL) {
+        lineno++;
+        if (strcmp(lin, quit) == 0)
+            break;
         if (firstline) {
             char* p = lin;
             if (lin[0] == '#')
@@ -145,17 +267,45 @@ void getlst_1(FILE* fp, char* quit, struct lnode* p1, struct lnode* p2)
             if (!*p)
                 continue;
             firstline = 0;
+            rule_line = lineno;
         }
         insert(install(lin), p2);
     }
 }
 
+/* new_stat - profile entry for a rule starting at rule_line in name */
+struct rstat* new_stat(char* name, struct lnode* last)
+{
+    struct rstat* r;
+    char* p;
+    char key[MAXLINE];
+
+    r = (struct rstat*)calloc(1, sizeof(struct rstat));
+    if (r == NULL)
+        error("init: out of memory\n");
+    snprintf(key, MAXLINE, "%s:%d", name, rule_line);
+    r->r_key = install(key);
+    strcpy(key, last->l_text);
+    p = key;
+    while (*p && *p != '\n') {
+        if (*p == '\t')
+            *p = ' ';
+        p++;
+    }
+    *p = 0;
+    r->r_text = install(key);
+    r->r_next = rstats;
+    rstats = r;
+    return r;
+}
+
 /* init - read patterns file */
-void init(FILE* fp)
+void init(FILE* fp, char* name)
 {
     struct lnode head, tail;
     struct onode *p, **next;
 
+    lineno = 0;
     next = &opts;
     while (*next)
         next = &((*next)->o_next);
@@ -178,6 +328,9 @@ void init(FILE* fp)
         if (head.l_next)
             head.l_next->l_prev = 0;
         p->o_new = head.l_next;
+        p->o_stat = 0;
+        if (profile)
+            p->o_stat = new_stat(name, p->o_old);
 
         *next = p;
         next = &p->o_next;
@@ -185,6 +338,92 @@ void init(FILE* fp)
     *next = 0;
 }
 
+/* line_key - hash the leading white space and mnemonic of a line. For a
+   pattern return -1 if a variable appears before the mnemonic ends */
+int line_key(char* s, int pattern)
+{
+    unsigned h = 0;
+
+    while (*s == ' ' || *s == '\t')
+        h = h * 33 + *s++;
+    while (*s && !isspace((unsigned char)*s)) {
+        if (pattern && *s == '%')
+            return -1;
+        h = h * 33 + *s++;
+    }
+    if (pattern && *s == 0)
+        return -1;
+    return (h ^ (h >> 7)) % RHASH;
+}
+
+/* build_index - sort the rules onto the key chains in rule order */
+void build_index(void)
+{
+    static struct onode** tails[RHASH];
+    struct onode **wtail, *o;
+    unsigned seq = 0;
+    int i;
+
+    for (i = 0; i < RHASH; i++) {
+        rhash[i] = 0;
+        tails[i] = &rhash[i];
+    }
+    rwild = 0;
+    wtail = &rwild;
+    for (o = opts; o; o = o->o_next) {
+        o->o_seq = seq++;
+        o->o_hnext = 0;
+        /* Empty rules never match so don't index them */
+        if (o->o_old == 0)
+            continue;
+        i = line_key(o->o_old->l_text, 1);
+        if (i == -1) {
+            *wtail = o;
+            wtail = &o->o_hnext;
+        } else {
+            *tails[i] = o;
+            tails[i] = &o->o_hnext;
+        }
+    }
+    rindex_dirty = 0;
+}
+
+/* nsec_now - time for the profiler if we have a clock */
+unsigned long nsec_now(void)
+{
+#ifdef CLOCK_MONOTONIC
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+/* charge - add the time since t to the rule being profiled */
+void charge(struct rstat** rp, unsigned long t)
+{
+    if (*rp) {
+        (*rp)->r_nsec += nsec_now() - t;
+        *rp = 0;
+    }
+}
+
+/* next_rule - next candidate from the keyed and wild lists in order */
+struct onode* next_rule(struct onode** kp, struct onode** wp)
+{
+    struct onode* o;
+    if (*kp && (*wp == 0 || (*kp)->o_seq < (*wp)->o_seq)) {
+        o = *kp;
+        *kp = o->o_hnext;
+    } else {
+        o = *wp;
+        if (o)
+            *wp = o->o_hnext;
+    }
+    return o;
+}
+
 /* match - check conditions in rules */
 /* format: %check min <= %n <= max */
 int check(char* pat, char** vars)
@@ -343,7 +582,7 @@ struct lnode* rep(
         psav = p->l_next;
         if (debug)
             fputs(p->l_text, stderr);
-        free(p);
+        free_lnode(p);
     }
     connect(p1, p2);
     if (debug)
@@ -406,13 +645,28 @@ struct lnode* opt(struct lnode* r)
     char* vars[10];
     int i, lines;
     struct lnode *c, *p;
-    struct onode* o;
+    struct onode *o, *kn, *wn;
+    int linear = 0;
+    struct rstat* rs = 0;
+    unsigned long t = 0;
     static char* activated = "%activated ";
 
-    for (o = opts; o; o = o->o_next) {
+    /* Only the rules whose last line can match r need trying */
+    if (rindex_dirty)
+        build_index();
+    kn = rhash[line_key(r->l_text, 0)];
+    wn = rwild;
+
+    for (o = next_rule(&kn, &wn); o; o = linear ? o->o_next : next_rule(&kn, &wn)) {
+        charge(&rs, t);
         activerule = o;
         if (o->firecount < 1)
             continue;
+        if (o->o_stat) {
+            rs = o->o_stat;
+            rs->r_tries++;
+            t = nsec_now();
+        }
         c = r;
         p = o->o_old;
         if (debug) {
@@ -452,7 +706,7 @@ struct lnode* opt(struct lnode* r)
             struct lnode* tmp = o->o_new; /* delete the %once line */
             o->o_new = o->o_new->l_next;
             o->o_new->l_prev = 0;
-            free(tmp);
+            free_lnode(tmp);
             o->firecount = 0; /* never again */
         }
 
@@ -479,6 +733,8 @@ struct lnode* opt(struct lnode* r)
             if (!lnp || skip)
                 continue;
             insert(install(signature), lnp);
+            if (rs)
+                rs->r_fires++;
 
             if (debug) {
                 fputs("matched pattern:\n", stderr);
@@ -497,6 +753,7 @@ struct lnode* opt(struct lnode* r)
                     error("activate: out of memory\n");
                 nn->o_old = 0, nn->o_new = 0;
                 nn->firecount = MAXFIRECOUNT;
+                nn->o_stat = o->o_stat;
                 lnp = copylist(lnp, &nn->o_old, &nn->o_new, vars);
                 nn->o_next = last->o_next;
                 last->o_next = nn;
@@ -513,18 +770,229 @@ struct lnode* opt(struct lnode* r)
             while (--lines && r->l_prev)
                 r = r->l_prev;
             global_again = 1; /* signalize changes */
+            /* r has moved and there are new rules so carry on down
+               the whole list as before, and reindex next time */
+            linear = 1;
+            rindex_dirty = 1;
             continue;
         }
 
         /* fire the rule */
+        if (rs) {
+            rs->r_fires++;
+            rs->r_removed += lines;
+            for (p = o->o_new; p; p = p->l_next)
+                rs->r_added++;
+        }
         r = rep(c, r->l_next, o->o_new, vars);
+        charge(&rs, t);
         activerule = 0;
         return r;
     }
+    charge(&rs, t);
     activerule = 0;
     return r->l_next;
 }
 
+/* stat_order - most fired first, then most tried */
+int stat_order(const void* a, const void* b)
+{
+    const struct rstat* ra = *(const struct rstat**)a;
+    const struct rstat* rb = *(const struct rstat**)b;
+    if (ra->r_fires != rb->r_fires)
+        return ra->r_fires < rb->r_fires ? 1 : -1;
+    if (ra->r_tries != rb->r_tries)
+        return ra->r_tries < rb->r_tries ? 1 : -1;
+    return strcmp(ra->r_key, rb->r_key);
+}
+
+/* write_profile - merge our counts into the profile report. Every copt
+   in a build adds to the same file so hold a lock while updating it */
+void write_profile(void)
+{
+    FILE* fp;
+    int fd;
+    char lin[512], key[MAXLINE];
+    char *p, *k;
+    unsigned long n[5];
+    struct rstat *r, **tab;
+    unsigned num = 0, i;
+
+    fd = open(profile, O_RDWR | O_CREAT, 0644);
+    if (fd == -1 || (fp = fdopen(fd, "r+")) == NULL) {
+        perror(profile);
+        return;
+    }
+#ifdef F_SETLKW
+    {
+        struct flock fl;
+        memset(&fl, 0, sizeof(fl));
+        fl.l_type = F_WRLCK;
+        fl.l_whence = SEEK_SET;
+        fcntl(fd, F_SETLKW, &fl);
+    }
+#endif
+    while (fgets(lin, sizeof(lin), fp)) {
+        if (sscanf(lin, "%lu %lu %lu %lu %lu %127s",
+                &n[0], &n[1], &n[2], &n[3], &n[4], key) != 6)
+            continue;
+        /* Keys are installed so we can compare pointers */
+        k = install(key);
+        for (r = rstats; r; r = r->r_next)
+            if (r->r_key == k)
+                break;
+        if (r == NULL) {
+            r = (struct rstat*)calloc(1, sizeof(struct rstat));
+            if (r == NULL)
+                error("profile: out of memory\n");
+            p = strstr(lin, key) + strlen(key);
+            if (*p == ' ')
+                p++;
+            p[strcspn(p, "\n")] = 0;
+            r->r_key = k;
+            r->r_text = install(p);
+            r->r_next = rstats;
+            rstats = r;
+        }
+        r->r_fires += n[0];
+        r->r_tries += n[1];
+        r->r_removed += n[2];
+        r->r_added += n[3];
+        r->r_nsec += n[4] * 1000;
+    }
+    for (r = rstats; r; r = r->r_next)
+        num++;
+    tab = (struct rstat**)malloc((num + 1) * sizeof(struct rstat*));
+    if (tab == NULL)
+        error("profile: out of memory\n");
+    for (i = 0, r = rstats; r; r = r->r_next)
+        tab[i++] = r;
+    qsort(tab, num, sizeof(struct rstat*), stat_order);
+
+    rewind(fp);
+    if (ftruncate(fd, 0) == -1)
+        perror(profile);
+    fprintf(fp, "#     fires      tries  removed    added       usec rule\n");
+    for (i = 0; i < num; i++) {
+        r = tab[i];
+        fprintf(fp, "%11lu %10lu %8lu %8lu %10lu %s %s\n",
+            r->r_fires, r->r_tries, r->r_removed, r->r_added,
+            r->r_nsec / 1000, r->r_key, r->r_text);
+    }
+    free(tab);
+    fclose(fp);
+}
+
+/* build_pattern_index - chain every distinct pattern line by its key */
+int build_pattern_index(void)
+{
+    struct onode* o;
+    struct lnode* l;
+    struct pnode *n, **pp;
+    int k;
+
+    for (o = opts; o; o = o->o_next) {
+        /* Activation reruns the whole file, which streaming can't do */
+        for (l = o->o_new; l; l = l->l_next)
+            if (strcmp(l->l_text, "%activate\n") == 0)
+                return 0;
+        for (l = o->o_old; l; l = l->l_prev) {
+            if (strncmp(l->l_text, "%check", 6) == 0 || strncmp(l->l_text, "%eval", 5) == 0)
+                continue;
+            k = line_key(l->l_text, 1);
+            pp = k == -1 ? &pwild : &phash[k];
+            /* Installed strings so pointers compare */
+            for (n = *pp; n; n = n->p_next)
+                if (n->p_text == l->l_text)
+                    break;
+            if (n)
+                continue;
+            n = (struct pnode*)malloc(sizeof(struct pnode));
+            if (n == NULL)
+                error("init: out of memory\n");
+            n->p_text = l->l_text;
+            n->p_next = *pp;
+            *pp = n;
+        }
+    }
+    return 1;
+}
+
+/* match_none - true if no pattern line can match s. With fresh variables
+   a failed match can't succeed whatever the variables hold */
+int match_none(char* s)
+{
+    char* vars[10];
+    struct pnode* n;
+    int i;
+
+    for (n = phash[line_key(s, 0)]; n; n = n->p_next) {
+        for (i = 0; i < 10; i++)
+            vars[i] = 0;
+        if (match(s, n->p_text, vars))
+            return 0;
+    }
+    for (n = pwild; n; n = n->p_next) {
+        for (i = 0; i < 10; i++)
+            vars[i] = 0;
+        if (match(s, n->p_text, vars))
+            return 0;
+    }
+    return 1;
+}
+
+/* flush - write out and free the lines after head up to and including b */
+void flush(struct lnode* head, struct lnode* b, FILE* out)
+{
+    struct lnode *p, *n, *end = b->l_next;
+
+    for (p = head->l_next; p != end; p = n) {
+        n = p->l_next;
+        fputs(p->l_text, out);
+        free_lnode(p);
+    }
+    connect(head, end);
+}
+
+/*
+ *	Streaming mode. A rule fires on lines ending at the current one and
+ *	then the scan carries on from the first line it made, so the scan
+ *	only ever goes back as far as a rule can match. A line that no
+ *	pattern line matches can't be part of any match, so once the scan is
+ *	past one it and everything before it are done and can go out. The
+ *	head node can't match anything either so it stands in for them.
+ *
+ *	Without %activate there is only ever one pass so the output is the
+ *	same as reading everything first.
+ */
+void stream(FILE* in, FILE* out)
+{
+    char lin[MAXLINE];
+    struct lnode head, tail, *p, *barrier = 0;
+
+    connect(&head, &tail);
+    head.l_prev = 0;
+    head.l_text = tail.l_text = "";
+
+    p = &tail;
+    for (;;) {
+        if (p == &tail) {
+            if (fgets(lin, MAXLINE, in) == NULL)
+                break;
+            if (barrier) {
+                flush(&head, barrier, out);
+                barrier = 0;
+            }
+            insert(install(lin), &tail);
+            p = tail.l_prev;
+            if (match_none(p->l_text))
+                barrier = p;
+        }
+        p = opt(p);
+    }
+    printlines(head.l_next, &tail, out);
+}
+
 /* #define _TESTING */
 
 /* main - peephole optimizer */
@@ -533,15 +1001,32 @@ int main(int argc, char** argv)
     FILE* fp;
 
     int i, pass;
+    int streaming;
     struct lnode head, *p, tail;
 
+    /* Rule profiling, see write_profile() */
+    profile = getenv("COPT_PROFILE");
+    if (profile && !*profile)
+        profile = NULL;
+    /* Streaming as if -s, set by cc --copt-stream */
+    streaming = getenv("COPT_STREAM") != NULL;
+
     for (i = 1; i < argc; i++)
         if (strcasecmp(argv[i], "-D") == 0)
             debug = 1;
+        else if (strcmp(argv[i], "-s") == 0)
+            streaming = 1;
         else if ((fp = fopen(argv[i], "r")) == NULL)
             error("copt: can't open patterns file\n");
         else
-            init(fp);
+            init(fp, argv[i]);
+
+    if (streaming && build_pattern_index()) {
+        stream(stdin, stdout);
+        if (profile)
+            write_profile();
+        exit(0);
+    }
 
     getlst(stdin, "", &head, &tail);
 
@@ -563,6 +1048,8 @@ int main(int argc, char** argv)
     }
 
     printlines(head.l_next, &tail, stdout);
+    if (profile)
+        write_profile();
     exit(0);
     return 1; /* make compiler happy */
 }
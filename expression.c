@@ -861,17 +861,21 @@ void expression_or_null(unsigned mkbool, unsigned flags)
 	}
 }
 
-/* This is used for return */
-void expression_typed(unsigned type)
+/* This is used for return. Returns 1 if the value is that of a function
+   call unchanged so the backend can treat it as a tail call */
+unsigned expression_typed(unsigned type)
 {
 	register struct node *n;
+	unsigned tail;
 	if (type == VOID && token == T_SEMICOLON) {
 		write_tree(tree(T_NULL, NULL, NULL));
-		return;
+		return 0;
 	}
 	n = typeconv(expression_tree(0), type, 0);
 	/* Don't lose return statements */
 	if (n->flags & NORETURN)
 		fatal("nret");
+	tail = n->op == T_CLEANUP && n->left->op == T_FUNCCALL;
 	write_tree(n);
+	return tail;
 }
@@ -4,5 +4,5 @@ extern void expression_or_null(unsigned mkbool, unsigned noret);
 extern unsigned const_int_expression(void);
 extern struct node *expression_tree(unsigned comma);
 extern struct node *hier0(unsigned comma);	/* needed for primary bracketed */
-extern void expression_typed(unsigned type);
+extern unsigned expression_typed(unsigned type);
 extern struct node *logic_expression(unsigned *t);
@@ -19,6 +19,7 @@
 #include "target.h"
 
 static char *symtab;
+static int symfd = -1;		/* Symbol file when streaming names */
 
 /* _itoa : always use our own inbuilt one. We don't want to suck in all
    of sscanf */
@@ -257,7 +258,11 @@ static void directive(void)
 }
 
 
+#if MAXNAME > 1024
+#define NHASH	1024
+#else
 #define NHASH	64
+#endif
 
 /* We could infer the symbol number from the table position in theory */
 
@@ -300,24 +305,102 @@ static struct name *find_symbol(const char *name, unsigned hash)
 }
 
 /*
- *	A simple but adequate hashing algorithm. A better one would
- *	be worth it for performance.
+ *	Hash a name. Summing the bytes put names like foo1..foo9 or the
+ *	__cc helpers all on a couple of chains. Hosted builds use FNV-1a,
+ *	native ones the xor form of djb2 which needs no long multiply. The
+ *	top bits are folded down as we only keep the bottom ones.
  */
 static unsigned hash_symbol(const char *name)
 {
-	int hash = 0;
+#if MAXNAME > 1024
+	uint32_t hash = 2166136261UL;
+	uint8_t n = 0;
+
+	while (*name && n++ < NAMELEN) {
+		hash ^= (uint8_t)*name++;
+		hash *= 16777619UL;
+	}
+	hash ^= hash >> 16;
+#else
+	uint16_t hash = 5381;
 	uint8_t n = 0;
 
 	while (*name && n++ < NAMELEN)
-		hash += *name++;
+		hash = ((hash << 5) + hash) ^ (uint8_t)*name++;
+	hash ^= hash >> 8;
+#endif
 	return (hash & (NHASH - 1));
 }
 
+#ifdef DEBUG
+/* Report how well the hash is spreading the names */
+static void hash_stats(void)
+{
+	unsigned i;
+	unsigned used = 0, longest = 0;
+	unsigned long probes = 0;
+	unsigned num = nextsym - symbols;
+	struct name *s;
+
+	for (i = 0; i < NHASH; i++) {
+		unsigned len = 0;
+		for (s = symhash[i]; s; s = s->next)
+			len++;
+		if (len)
+			used++;
+		if (len > longest)
+			longest = len;
+		probes += len * (len + 1) / 2;
+	}
+	fprintf(stderr, "cc0: %u names, %u/%u chains used, longest %u, %lu.%02lu compares per hit\n",
+		num, used, NHASH, longest, probes / num, (probes * 100 / num) % 100);
+}
+#endif
+
+/*
+ *	When our output is a pipe the later passes run alongside us and
+ *	may want a name before we finish. In that case each symbol record is
+ *	written into its slot as it is created, which is always before the
+ *	token that refers to it, and the table is never truncated.
+ */
+static void open_symbol_stream(void)
+{
+	symfd = open(symtab, O_WRONLY | O_CREAT, 0600);
+	if (symfd == -1) {
+		perror(symtab);
+		exit(1);
+	}
+}
+
+static void write_symbol(struct name *s)
+{
+	if (lseek(symfd, 2 + (s - symbase) * sizeof(struct name), SEEK_SET) < 0 ||
+	    write(symfd, s, sizeof(struct name)) != sizeof(struct name))
+		error("symbol I/O");
+}
+
+#ifdef FUSED
+/* In the single process compiler cc2 reads the names straight from here */
+struct name *fused_names;
+#endif
+
 static void write_symbol_table(void)
 {
 	unsigned len = (uint8_t *) nextsym - (uint8_t *) symbase;
 	uint8_t n[2];
 
+#ifdef FUSED
+	fused_names = symbase;
+	return;
+#endif
+	if (symfd != -1) {
+		n[0] = len;
+		n[1] = len >> 8;
+		if (lseek(symfd, 0L, SEEK_SET) < 0 || write(symfd, n, 2) != 2)
+			error("symbol I/O");
+		close(symfd);
+		return;
+	}
 	/* FIXME: proper temporary file! */
 	int fd = open(symtab, O_WRONLY | O_CREAT | O_TRUNC, 0600);
 	if (fd == -1) {
@@ -490,7 +573,10 @@ static unsigned tokenize_symbol(unsigned c)
 	s = find_symbol(symstr, h);
 	if (s)
 		return s->id;
-	return new_symbol(symstr, h, symnum++)->id;
+	s = new_symbol(symstr, h, symnum++);
+	if (symfd != -1)
+		write_symbol(s);
+	return s->id;
 }
 
 /*
@@ -1255,6 +1341,8 @@ int main(int argc, char *argv[])
 	if (symtab == NULL)
 		symtab = ".symtab";
 	keywords();
+	if (lseek(1, 0L, SEEK_CUR) == -1)
+		open_symbol_stream();
 	do {
 		t = tokenize();
 		write_token(t);
@@ -1262,5 +1350,8 @@ int main(int argc, char *argv[])
 	/* Write the remaining decode */
 	outflush();
 	write_symbol_table();
+#ifdef DEBUG
+	hash_stats();
+#endif
 	return err;
 }
@@ -0,0 +1,119 @@
+/*
+ *	Single process compiler for cross builds
+ *
+ *	On a hosted system there is no need for the process split that lets
+ *	the compiler run on small machines. This runs cc0, cc1, cc1b (if
+ *	CCALL_TREEOPT is set, see cc --tree-opt), cc2 and copt one after
+ *	another in the same process, handing the token stream, trees and
+ *	assembler between them in memory.
+ *	cc2 also looks the names up directly in the cc0 tables (see FUSED in
+ *	frontend.c and backend.c).
+ *
+ *	Each pass is linked in with all of its symbols made local except for
+ *	its renamed main (see the Makefile), so the passes keep their own
+ *	globals just as if they were separate programs. As each pass runs
+ *	exactly once per process they start from clean state too.
+ *
+ *	ccall.cpu cpucode optlevel features rules [codeseg]
+ *
+ *	reads the preprocessed source on stdin and writes the assembler
+ *	on stdout.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+extern int cc0_main(int argc, char *argv[]);
+extern int cc1_main(int argc, char *argv[]);
+extern int cc1b_main(int argc, char *argv[]);
+extern int cc2_main(int argc, char *argv[]);
+extern int copt_main(int argc, char *argv[]);
+
+/* A seekable in memory file. cc1 needs to seek to fix up headers */
+static int membuf(void)
+{
+	FILE *f;
+#ifdef __linux__
+	int fd = memfd_create("fcc", 0);
+	if (fd != -1)
+		return fd;
+#endif
+	/* Left open for the life of the process */
+	f = tmpfile();
+	if (f == NULL) {
+		perror("tmpfile");
+		exit(1);
+	}
+	return fileno(f);
+}
+
+static void run_pass(int (*pass)(int, char *[]), char *argv[], int in, int out)
+{
+	int argc = 0;
+
+	while (argv[argc])
+		argc++;
+	/* The input may be a pipe from the driver, in which case it is not
+	   going to rewind and doesn't need to */
+	lseek(in, 0L, SEEK_SET);
+	if (dup2(in, 0) == -1 || dup2(out, 1) == -1) {
+		perror("dup2");
+		exit(1);
+	}
+	if (pass(argc, argv))
+		exit(1);
+	fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+	char *cc0_argv[] = { "cc0", "-", NULL };
+	char *cc1_argv[] = { "cc1", NULL, NULL, NULL, NULL };
+	char *cc1b_argv[] = { "cc1b", NULL };
+	char *cc2_argv[] = { "cc2", "-", NULL, NULL, NULL, NULL, NULL };
+	char *copt_argv[] = { "copt", NULL, NULL };
+	int in, out;
+	int tokens, trees, code, opt;
+
+	if (argc != 5 && argc != 6) {
+		fprintf(stderr, "%s: cpucode optlevel features rules [codeseg]\n", argv[0]);
+		exit(1);
+	}
+	cc1_argv[1] = argv[1];
+	cc1_argv[2] = argv[3];
+	cc1_argv[3] = argv[2];
+	cc2_argv[2] = argv[1];
+	cc2_argv[3] = argv[2];
+	cc2_argv[4] = argv[3];
+	cc2_argv[5] = argv[5];
+	copt_argv[1] = argv[4];
+
+	in = dup(0);
+	out = dup(1);
+	tokens = membuf();
+	trees = membuf();
+
+	run_pass(cc0_main, cc0_argv, in, tokens);
+	run_pass(cc1_main, cc1_argv, tokens, trees);
+	if (getenv("CCALL_TREEOPT")) {
+		opt = membuf();
+		run_pass(cc1b_main, cc1b_argv, trees, opt);
+		trees = opt;
+	}
+	if (*argv[2] == '0') {
+		run_pass(cc2_main, cc2_argv, trees, out);
+		return 0;
+	}
+	code = membuf();
+	run_pass(cc2_main, cc2_argv, trees, code);
+	/* copt exits when done */
+	run_pass(copt_main, copt_argv, code, out);
+	return 0;
+}
@@ -24,7 +24,8 @@ void footer(unsigned htype, unsigned name, unsigned data)
 	header(htype | H_FOOTER, name, data);
 }
 
-void rewrite_header(unsigned long pos, unsigned htype, unsigned name, unsigned data)
+/* Rewrite a header within the output we are still holding */
+void update_header(unsigned long pos, unsigned htype, unsigned name, unsigned data)
 {
 	unsigned long curr = out_tell();
 	out_seek(pos);
@@ -32,7 +33,14 @@ void rewrite_header(unsigned long pos, unsigned htype, unsigned name, unsigned d
 	out_seek(curr);
 }
 
+void rewrite_header(unsigned long pos, unsigned htype, unsigned name, unsigned data)
+{
+	update_header(pos, htype, name, data);
+	out_release();
+}
+
 unsigned long mark_header(void)
 {
+	out_hold();
 	return out_tell();
 }
@@ -24,12 +24,12 @@ struct header {
 #define H_DO		0x0008	/* start of do-while */
 #define H_DOWHILE	0x0009	/* do .. while expr */
 #define H_FOR		0x000A	/* for */
-#define H_SWITCH	0x000B	/* switch */
+#define H_SWITCH	0x000B	/* switch, data is the table header type */
 #define H_CASE		0x000C	/* case */
 #define H_DEFAULT	0x000D	/* default */
 #define H_BREAK		0x000E	/* break */
 #define H_CONTINUE	0x000F	/* continue */
-#define H_RETURN	0x0010	/* return */
+#define H_RETURN	0x0010	/* return, data is 1 if the value is a call */
 #define H_LABEL		0x0011	/* goto label */
 #define H_GOTO		0x0012	/* goto */
 #define H_STRING	0x0013	/* string */
@@ -37,10 +37,13 @@ struct header {
 #define H_EXPORT	0x0015	/* make name public */
 #define H_DATA		0x0016	/* data segment */
 #define H_BSS		0x0017	/* uninitialized data */
-#define H_SWITCHTAB	0x0018	/* switch jump table */
+#define H_SWITCHTAB	0x0018	/* switch table searched in order */
 #define H_ARGFRAME	0x0019	/* argument frame size info */
+#define H_SWITCHJT	0x001A	/* switch table indexed by value */
+#define H_SWITCHBS	0x001B	/* switch table sorted by value */
 
 extern void header(unsigned htype, unsigned name, unsigned data);
 extern void footer(unsigned htype, unsigned name, unsigned data);
 extern void rewrite_header(unsigned long off, unsigned htype, unsigned name, unsigned data);
+extern void update_header(unsigned long off, unsigned htype, unsigned name, unsigned data);
 extern unsigned long mark_header(void);
@@ -0,0 +1,10 @@
+#ifndef HOST_H
+#define HOST_H
+
+/* Building on a big Unix box rather than on the small target itself */
+#if defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__) || \
+    defined(__NetBSD__) || defined(__OpenBSD__)
+#define HOSTED
+#endif
+
+#endif
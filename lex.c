@@ -44,8 +44,47 @@ static unsigned char *outptr = outbuf;
 static unsigned int outlen;
 static unsigned int outrecord = 0;
 
+/*
+ *	If the output is a pipe we cannot go back and rewrite headers. In
+ *	that case records from the marked header onwards are held in memory
+ *	until the rewrite is done and then sent on in order.
+ */
+static unsigned outpipe;		/* 1 seekable, 2 pipe */
+static unsigned char *holdbuf;
+static unsigned holdbase;
+static unsigned holdsize;
+static unsigned holding;
+
+static unsigned out_is_pipe(void)
+{
+	if (outpipe == 0)
+		outpipe = lseek(1, 0L, SEEK_CUR) < 0 ? 2 : 1;
+	return outpipe == 2;
+}
+
+static void out_held(void)
+{
+	unsigned n = outrecord - holdbase + 1;
+	if (n > holdsize) {
+		holdsize = n + 16;
+		holdbuf = realloc(holdbuf, holdsize * 128L);
+		if (holdbuf == NULL)
+			fatal("out of memory");
+	}
+	memcpy(holdbuf + (outrecord - holdbase) * 128L, outbuf, outlen);
+}
+
 void out_write(void)
 {
+	if (out_is_pipe()) {
+		if (holding)
+			out_held();
+		else if (outlen && write(1, outbuf, outlen) != outlen)
+			fatal("write error");
+		outlen = 0;
+		outptr = outbuf;
+		return;
+	}
 	if (lseek(1, outrecord * 128L, SEEK_SET) < 0)
 		fatal("seek error");
 	if (outlen && write(1, outbuf, outlen) != outlen)
@@ -65,6 +104,11 @@ void out_flush(void)
    update headers */
 static void out_record_read(unsigned record)
 {
+	if (holding) {
+		memcpy(outbuf, holdbuf + (record - holdbase) * 128L, 128);
+		outrecord = record;
+		return;
+	}
 	if (lseek(1, record * 128L, SEEK_SET) < 0)
 		fatal("seek error");
 	if (read(1, outbuf, 128) < 0)
@@ -87,6 +131,26 @@ void out_seek(unsigned long pos)
 	outptr = outbuf + outlen;
 }
 
+/* Start holding output so that it can be rewritten */
+void out_hold(void)
+{
+	if (out_is_pipe()) {
+		holdbase = outrecord;
+		holding = 1;
+	}
+}
+
+/* Rewriting is done, send on the completed records we held */
+void out_release(void)
+{
+	unsigned n = outrecord - holdbase;
+	if (!holding)
+		return;
+	holding = 0;
+	if (n && write(1, holdbuf, n * 128) != n * 128)
+		fatal("write error");
+}
+
 /* Add bytes at the current position */
 void out_byte(unsigned char c)
 {
@@ -117,6 +181,60 @@ void out_block(void *pv, unsigned len)
 	}
 }
 
+/* Overwrite len bytes from off bytes after a position we noted before */
+void out_rewrite(unsigned long pos, unsigned off, void *pv, unsigned len)
+{
+	unsigned long curr = out_tell();
+	off += pos & 0xFF;
+	out_seek((((pos >> 8) + off / 128) << 8) | (off % 128));
+	out_block(pv, len);
+	out_seek(curr);
+}
+
+/* Bytes between two positions */
+static unsigned out_span(unsigned long a, unsigned long b)
+{
+	return ((b >> 8) - (a >> 8)) * 128 + (b & 0xFF) - (a & 0xFF);
+}
+
+static void out_read(unsigned char *p, unsigned len)
+{
+	while(len) {
+		register unsigned n;
+
+		if (outlen == 128) {
+			out_record_read(outrecord + 1);
+			outlen = 0;
+		}
+		n = 128 - outlen;
+		if (n > len)
+			n = len;
+		memcpy(p, outbuf + outlen, n);
+		outlen += n;
+		p += n;
+		len -= n;
+	}
+	outptr = outbuf + outlen;
+}
+
+/* Move what we wrote from 'from' on back to 'pos', ahead of what was
+   between them */
+void out_insert(unsigned long pos, unsigned long from)
+{
+	unsigned len = out_span(pos, out_tell());
+	unsigned mid = out_span(pos, from);
+	unsigned char *buf = malloc(len);
+
+	if (buf == NULL)
+		fatal("out of memory");
+	out_seek(pos);
+	out_read(buf, len);
+	out_seek(pos);
+	out_block(buf + mid, len - mid);
+	out_block(buf, mid);
+	free(buf);
+}
+
 char filename[33];
 
 unsigned line_num;
@@ -21,5 +21,9 @@ extern void out_write(void);
 extern void out_flush(void);
 extern unsigned long out_tell(void);
 extern void out_seek(unsigned long pos);
+extern void out_hold(void);
+extern void out_release(void);
 extern void out_byte(unsigned char c);
 extern void out_block(void *pv, unsigned len);
+extern void out_rewrite(unsigned long pos, unsigned off, void *pv, unsigned len);
+extern void out_insert(unsigned long pos, unsigned long from);
@@ -16,6 +16,7 @@ unsigned voltrack;		/* Track possible volatiles */
 unsigned in_sizeof;		/* Set if we are in sizeof() */
 unsigned cputype;		/* So the target specific code can make decisions */
 unsigned long cpufeat;		/* CPU feature flags from user for target specific code */
+unsigned optlevel;		/* 0-9, from -O */
 
 /*
  *	A C program consists of a series of declarations that by default
@@ -41,12 +42,14 @@ static unsigned functype[2] = {
 
 int main(int argc, char *argv[])
 {
-	if (argc != 3) {
-		error("cc1 cpuname features");
+	if (argc != 3 && argc != 4) {
+		error("cc1 cpuname features [optlevel]");
 		exit(1);
 	}
 	cputype = atoi(argv[1]);
 	cpufeat = atol(argv[2]);
+	if (argc == 4 && *argv[3] >= '0' && *argv[3] <= '9')
+		optlevel = *argv[3] - '0';
 	next_token();
 	init_nodes();
 	/* A function with no type info returning INT */
@@ -3,6 +3,7 @@
  */
 
 #include <stdio.h>
+#include <stddef.h>
 #include "compiler.h"
 
 /* These track which registers are aliases to arguments and must be
@@ -71,3 +72,200 @@ unsigned arg_size(void)
 {
     return arg_frame;
 }
+
+/*
+ *	At -O2 the registers nobody declared register go to the busiest
+ *	locals and arguments. write_tree tells us where it put each direct
+ *	read or write of one, and anything else done with a variable rules it
+ *	out. A use inside a loop counts as eight outside it. At the end of
+ *	the function the target hands out what it has left and we rewrite
+ *	the uses as T_REG where they lie.
+ */
+
+struct regvar {
+    unsigned op;		/* T_LOCAL or T_ARGUMENT */
+    unsigned long offset;
+    unsigned size;
+    unsigned type;
+    unsigned snum;
+    unsigned escaped;
+    unsigned long uses;		/* Weighted by loop depth */
+    unsigned reg;
+};
+
+unsigned loop_depth;
+
+static struct regvar regvar[NUM_REGVAR];
+static unsigned nregvar;
+static unsigned long use_pos[NUM_REGUSE];
+static unsigned char use_var[NUM_REGUSE];
+static unsigned nuse;
+static unsigned tracking;	/* 1 following, 2 gave up */
+
+/* Most targets have nothing to hand out. fcc has no weak symbols but the
+   native build links target-8080 which has its own */
+#ifdef __GNUC__
+__attribute__((weak)) unsigned target_autoreg(unsigned type)
+{
+    return 0;
+}
+#endif
+
+void init_regvars(void)
+{
+    nregvar = 0;
+    nuse = 0;
+    loop_depth = 0;
+    tracking = optlevel >= 2;
+}
+
+/* A local or argument about to be written at the current position. use
+   is the type it is read or written as directly, VOID if it isn't */
+void note_regvar(struct node *n, unsigned use)
+{
+    struct regvar *v;
+    unsigned d = loop_depth;
+
+    if (tracking != 1)
+        return;
+    for (v = regvar; v < regvar + nregvar; v++)
+        if (v->op == n->op && v->offset == n->value &&
+            v->type == n->type && v->snum == n->snum)
+            break;
+    if (v == regvar + nregvar) {
+        if (nregvar == NUM_REGVAR) {
+            tracking = 2;
+            return;
+        }
+        nregvar++;
+        v->op = n->op;
+        v->offset = n->value;
+        /* Arrays and structures only by name, as cc1b does */
+        v->size = 0;
+        if (!IS_ARRAY(n->type) && (PTR(n->type) || n->type < VOID))
+            v->size = type_sizeof(n->type);
+        v->type = n->type;
+        v->snum = n->snum;
+        v->escaped = 0;
+        v->uses = 0;
+        v->reg = 0;
+    }
+    if (use != n->type || (n->flags & (LVAL | SIDEEFFECT)) != LVAL) {
+        v->escaped = 1;
+        return;
+    }
+    if (nuse == NUM_REGUSE) {
+        tracking = 2;
+        return;
+    }
+    if (d > 4)
+        d = 4;
+    v->uses += 1UL << (3 * d);
+    use_pos[nuse] = out_tell();
+    use_var[nuse++] = v - regvar;
+}
+
+/* Unions, members and block scopes can share storage, and a member
+   reached some other way can lead to the rest */
+static unsigned shared(struct regvar *v)
+{
+    struct regvar *w;
+    for (w = regvar; w < regvar + nregvar; w++) {
+        if (w == v || w->op != v->op)
+            continue;
+        if (w->escaped && w->snum == v->snum)
+            return 1;
+        if (w->offset < v->offset + v->size && v->offset < w->offset + w->size)
+            return 1;
+    }
+    return 0;
+}
+
+static struct regvar *busiest(void)
+{
+    struct regvar *v, *best = NULL;
+    for (v = regvar; v < regvar + nregvar; v++) {
+        if (v->escaped || v->reg || v->size == 0 ||
+            (!PTR(v->type) && v->type >= CLONG))
+            continue;
+        /* An argument needs one more use to pay for its load */
+        if (v->uses < 2 + (v->op == T_ARGUMENT))
+            continue;
+        if (best == NULL || v->uses > best->uses)
+            best = v;
+    }
+    return best;
+}
+
+/* Give out the registers left, rewrite the uses and load the arguments
+   that moved at body, the start of the function body */
+void assign_regvars(unsigned long body)
+{
+    struct regvar *v;
+    struct node *n, *r;
+    unsigned long end, reg;
+    unsigned op = T_REG;
+    unsigned moved = 0;
+    unsigned i;
+
+    if (tracking != 1) {
+        tracking = 0;
+        return;
+    }
+    tracking = 0;
+    while ((v = busiest()) != NULL) {
+        if (!shared(v))
+            v->reg = target_autoreg(v->type);
+        if (v->reg)
+            moved = 1;
+        else
+            v->uses = 0;
+    }
+    if (!moved)
+        return;
+    for (i = 0; i < nuse; i++) {
+        v = regvar + use_var[i];
+        if (v->reg == 0)
+            continue;
+        reg = v->reg;
+        out_rewrite(use_pos[i], offsetof(struct node, op), &op, sizeof(op));
+        out_rewrite(use_pos[i], offsetof(struct node, value), &reg, sizeof(reg));
+    }
+    /* The stack space of the locals we moved may now be spare, if we know
+       where all the others are */
+    end = 0;
+    for (v = regvar; v < regvar + nregvar; v++) {
+        if (v->op != T_LOCAL || v->reg)
+            continue;
+        if (v->escaped || v->size == 0) {
+            end = local_max;
+            break;
+        }
+        if (v->offset + v->size > end)
+            end = v->offset + v->size;
+    }
+    if (end < local_max)
+        local_max = end;
+    /* As load_registers does for arguments declared register */
+    end = out_tell();
+    for (v = regvar; v < regvar + nregvar; v++) {
+        if (v->op != T_ARGUMENT || v->reg == 0)
+            continue;
+        n = new_node();
+        n->op = T_ARGUMENT;
+        n->value = v->offset;
+        n->type = v->type;
+        r = new_node();
+        r->op = T_REG;
+        r->value = v->reg;
+        r->type = v->type;
+        r->snum = v->snum;
+        r->flags = LVAL;
+        n = tree(T_EQ, r, tree(T_DEREF, NULL, n));
+        n->type = v->type;
+        n->flags |= NORETURN|SIDEEFFECT;
+        write_tree(n);
+    }
+    if (out_tell() != end)
+        out_insert(body, end);
+}
@@ -10,3 +10,8 @@ extern void init_storage(void);
 
 extern struct symbol *reg_load[NUM_REG + 1];
 extern unsigned reg_offset[NUM_REG + 1];
+
+extern unsigned loop_depth;
+extern void init_regvars(void);
+extern void note_regvar(struct node *n, unsigned use);
+extern void assign_regvars(unsigned long body);
@@ -8,13 +8,13 @@ __minusl:
 	; Subtract Y:D from TOS
 	std ,--s
 	sty ,--s
-	ldd 6,s		; low
+	ldd 8,s		; low
 	subd 2,s	; - low
 	exg d,y
-	ldd 4,s
+	ldd 6,s		; high
 	sbcb 1,s
 	sbca 0,s
 	exg d,y
-	ldx 4,s
-	leas 8,s
-	rts
+	ldx 4,s		; return address
+	leas 10,s	; our copy, return and the argument
+	jmp ,x
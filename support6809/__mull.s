@@ -71,8 +71,9 @@ norip16:
 ;	top 16 will overflow. Spot a 16bit zero and short cut as this
 ;	is common (eg for uint * ulong cases)
 ;
-	tfr	y,d	; again (b = sreg + 1)
+	leay	,y	; tfr does not set the flags
 	beq	is_done
+	tfr	y,d	; again (b = sreg + 1)
 	lda	9,s
 	mul
 	addb	1,s
@@ -87,6 +88,7 @@ norip16:
 ;	And finally the top 8bits so almost everything overflows
 ;
 	tfr	y,d
+	tsta
 	beq	is_done
 	ldb	9,s
 	mul
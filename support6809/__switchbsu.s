@@ -0,0 +1,53 @@
+	.export __switchbsu
+
+__switchbsu:
+	; X holds the switch table, D the value
+	; We can afford to trash Y
+	; The table is the length, value and label pairs in unsigned value
+	; order and the default label
+	pshs d			; The value
+	ldd ,x++		; Length
+	tfr d,y
+	aslb
+	rola
+	aslb
+	rola
+	ldd d,x			; The default label
+	pshs d
+	; Look in Y entries from X on
+next:
+	cmpy #0
+	beq default
+	tfr y,d
+	lsra
+	rorb
+	pshs d,y		; Half the length and the length
+	aslb
+	rola
+	aslb
+	rola
+	leay d,x		; Middle entry
+	ldd ,y
+	cmpd 6,s
+	beq match
+	bhi below
+	; Above the middle so look at those after it
+	leax 4,y
+	ldd 2,s
+	subd ,s
+	subd #1
+	tfr d,y
+	leas 4,s
+	bra next
+below:
+	ldy ,s			; Look at those before it
+	leas 4,s
+	bra next
+match:
+	ldx 2,y
+	leas 8,s
+	jmp ,x
+default:
+	puls x
+	leas 2,s
+	jmp ,x
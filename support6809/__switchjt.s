@@ -0,0 +1,16 @@
+	.export __switchjt
+
+__switchjt:
+	; X holds the switch table, D the value
+	; The table is the length, the lowest value, a label for each
+	; value from the lowest up and the default label
+	subd 2,x		; Offset from the lowest
+	cmpd ,x
+	blo intable
+	ldd ,x			; Outside the table so take the default
+intable:
+	leax 4,x
+	aslb
+	rola
+	ldx d,x
+	jmp ,x
@@ -0,0 +1,16 @@
+	.export __switchjtc
+
+__switchjtc:
+	; X holds the switch table, B the value
+	; As __switchjt but the lowest value is a byte
+	subb 2,x		; Offset from the lowest
+	clra
+	cmpd ,x
+	blo intable
+	ldd ,x			; Outside the table so take the default
+intable:
+	leax 3,x
+	aslb
+	rola
+	ldx d,x
+	jmp ,x
@@ -4,22 +4,21 @@
 		.setcpu 8080
 		.code
 
-		; We compute HL/DE but righh now we have BC / HL
+		; We compute HL/DE but right now we have BC / HL
 __bcdiv:
 		xchg
-		mov e,c
-		mov d,b
+		mov l,c
+		mov h,b
 		call __divde
 		mov c,l
-		mov h,b
+		mov b,h
 		ret
 
 __bcrem:
 		xchg
-		mov e,c
-		mov d,b
-		call __divde
-		xchg
-		mov c,l
+		mov l,c
 		mov h,b
+		call __remde
+		mov c,l
+		mov b,h
 		ret
@@ -1,22 +1,21 @@
 		.export __bcdivu
-		.export __bcmodu
+		.export __bcremu
 
-		; We compute HL/DE but righh now we have BC / HL
+		; We compute HL/DE but right now we have BC / HL
 __bcdivu:
 		xchg
-		mov e,c
-		mov d,b
+		mov l,c
+		mov h,b
 		call __divdeu
 		mov c,l
 		mov b,h
 		ret
 
-__bcmodu:
-		xchg
-		mov e,c
-		mov d,b
-		call __divdeu
+__bcremu:
 		xchg
+		mov l,c
+		mov h,b
+		call __remdeu
 		mov c,l
 		mov b,h
 		ret
@@ -0,0 +1,91 @@
+;
+;	Switch by binary search of a table sorted by unsigned value
+;
+			.export __switchbsu
+			.setcpu 8080
+			.code
+
+__switchbsu:
+		push	b
+		mov	b,h
+		mov	c,l
+		; DE points to the table in the format
+		; Length
+		; value, label (in order of value)
+		; default label
+		xchg
+		mov	e,m
+		inx	h
+		mov	d,m
+		inx	h
+		push	h
+		dad	d		; Find the default label
+		dad	d
+		dad	d
+		dad	d
+		xthl			; Keep it, HL is the first entry
+		; Look in DE entries from HL on
+next:
+		mov	a,d
+		ora	e
+		jz	default
+		push	d
+		push	h
+		mov	a,d		; Middle entry (ora cleared carry)
+		rar
+		mov	d,a
+		mov	a,e
+		rar
+		mov	e,a
+		dad	d
+		dad	d
+		dad	d
+		dad	d
+		inx	h
+		mov	a,m
+		dcx	h
+		cmp	b
+		jnz	notlow
+		mov	a,m
+		cmp	c
+		jz	match
+notlow:
+		jc	above
+		; The value is below the middle, DE is the count before it
+		pop	h
+		pop	psw
+		jmp	next
+above:
+		; The value is above the middle so look at those after it
+		inx	h
+		inx	h
+		inx	h
+		inx	h
+		pop	psw
+		xthl
+		mov	a,l
+		sub	e
+		mov	l,a
+		mov	a,h
+		sbb	d
+		mov	h,a
+		dcx	h
+		xchg
+		pop	h
+		jmp	next
+match:
+		pop	psw
+		pop	psw
+		pop	psw
+		inx	h
+		inx	h
+		jmp	jump
+default:
+		pop	h
+jump:
+		mov	e,m
+		inx	h
+		mov	d,m
+		xchg
+		pop	b
+		pchl
@@ -0,0 +1,47 @@
+;
+;	Switch through a jump table. Values outside the table take the
+;	default without a search
+;
+			.export __switchjt
+			.setcpu 8080
+			.code
+
+__switchjt:
+		push	b
+		; DE points to the table in the format
+		; Length
+		; Lowest value
+		; label for each value from the lowest up
+		; default label
+		xchg
+		mov	c,m
+		inx	h
+		mov	b,m
+		inx	h
+		mov	a,e		; Work out the offset from the lowest
+		sub	m
+		mov	e,a
+		inx	h
+		mov	a,d
+		sbb	m
+		mov	d,a
+		inx	h
+		mov	a,e		; Past the end (or below the lowest) ?
+		sub	c
+		mov	a,d
+		sbb	b
+		jnc	default
+		xchg
+		dad	h
+		dad	d
+		jmp	jump
+default:
+		dad	b
+		dad	b
+jump:
+		mov	e,m
+		inx	h
+		mov	d,m
+		xchg
+		pop	b
+		pchl
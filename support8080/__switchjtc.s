@@ -0,0 +1,42 @@
+;
+;	Switch through a jump table on a byte value
+;
+			.export __switchjtc
+			.setcpu 8080
+			.code
+
+__switchjtc:
+		push	b
+		; DE points to the table in the format
+		; Length
+		; Lowest value (byte)
+		; label for each value from the lowest up
+		; default label
+		xchg
+		mov	c,m
+		inx	h
+		mov	b,m
+		inx	h
+		mov	a,e		; Offset from the lowest
+		sub	m
+		inx	h
+		mov	e,a
+		mvi	d,0
+		sub	c		; Past the end ?
+		mov	a,d
+		sbb	b
+		jnc	default
+		xchg
+		dad	h
+		dad	d
+		jmp	jump
+default:
+		dad	b
+		dad	b
+jump:
+		mov	e,m
+		inx	h
+		mov	d,m
+		xchg
+		pop	b
+		pchl
@@ -1,11 +1,11 @@
 		.export __bcdivu
 		.export __bcremu
 
-		; We compute HL/DE but righh now we have BC / HL
+		; We compute HL/DE but right now we have BC / HL
 __bcdivu:
 		xchg
-		mov e,c
-		mov d,b
+		mov l,c
+		mov h,b
 		call __divdeu
 		mov c,l
 		mov b,h
@@ -13,10 +13,9 @@ __bcdivu:
 
 __bcremu:
 		xchg
-		mov e,c
-		mov d,b
-		call __divdeu
-		xchg
+		mov l,c
+		mov h,b
+		call __remdeu
 		mov c,l
 		mov b,h
 		ret
@@ -0,0 +1,85 @@
+;
+;	Switch by binary search of a table sorted by signed value. We flip
+;	the sign bits so that an unsigned compare does the job
+;
+		.export __switchbs
+		.code
+
+__switchbs:
+		push	bc
+		ld	a,h
+		xor	0x80
+		ld	b,a
+		ld	c,l
+		; DE points to the table in the format
+		; Length
+		; value, label (in order of value)
+		; default label
+		ex	de,hl
+		ld	e,(hl)
+		inc	hl
+		ld	d,(hl)
+		inc	hl
+		push	hl
+		add	hl,de		; Find the default label
+		add	hl,de
+		add	hl,de
+		add	hl,de
+		ex	(sp),hl		; Keep it, HL is the first entry
+		; Look in DE entries from HL on
+next:
+		ld	a,d
+		or	e
+		jr	z,default
+		push	de
+		push	hl
+		srl	d		; Middle entry
+		rr	e
+		add	hl,de
+		add	hl,de
+		add	hl,de
+		add	hl,de
+		inc	hl
+		ld	a,(hl)
+		xor	0x80
+		dec	hl
+		cp	b
+		jr	nz,notlow
+		ld	a,(hl)
+		cp	c
+		jr	z,match
+notlow:
+		jr	c,above
+		; The value is below the middle, DE is the count before it
+		pop	hl
+		pop	af
+		jr	next
+above:
+		; The value is above the middle so look at those after it
+		inc	hl
+		inc	hl
+		inc	hl
+		inc	hl
+		pop	af
+		ex	(sp),hl
+		scf
+		sbc	hl,de
+		ex	de,hl
+		pop	hl
+		jr	next
+match:
+		pop	af
+		pop	af
+		pop	af
+		inc	hl
+		inc	hl
+		jr	jump
+default:
+		pop	hl
+jump:
+		ld	e,(hl)
+		inc	hl
+		ld	d,(hl)
+		ex	de,hl
+		pop	bc
+		jp	(hl)
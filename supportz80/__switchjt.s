@@ -0,0 +1,46 @@
+;
+;	Switch through a jump table. Values outside the table take the
+;	default without a search
+;
+		.export __switchjt
+		.code
+
+__switchjt:
+		push	bc
+		; DE points to the table in the format
+		; Length
+		; Lowest value
+		; label for each value from the lowest up
+		; default label
+		ex	de,hl
+		ld	c,(hl)
+		inc	hl
+		ld	b,(hl)
+		inc	hl
+		ld	a,e		; Work out the offset from the lowest
+		sub	(hl)
+		ld	e,a
+		inc	hl
+		ld	a,d
+		sbc	a,(hl)
+		ld	d,a
+		inc	hl
+		ex	de,hl		; DE is the labels, HL the offset
+		or	a
+		sbc	hl,bc
+		jr	nc,default	; Past the end (or below the lowest)
+		add	hl,bc
+		add	hl,hl
+		add	hl,de
+		jr	jump
+default:
+		ex	de,hl
+		add	hl,bc
+		add	hl,bc
+jump:
+		ld	e,(hl)
+		inc	hl
+		ld	d,(hl)
+		ex	de,hl
+		pop	bc
+		jp	(hl)
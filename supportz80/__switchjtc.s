@@ -0,0 +1,42 @@
+;
+;	Switch through a jump table on a byte value
+;
+		.export __switchjtc
+		.code
+
+__switchjtc:
+		push	bc
+		; DE points to the table in the format
+		; Length
+		; Lowest value (byte)
+		; label for each value from the lowest up
+		; default label
+		ex	de,hl
+		ld	c,(hl)
+		inc	hl
+		ld	b,(hl)
+		inc	hl
+		ld	a,e		; Offset from the lowest
+		sub	(hl)
+		inc	hl
+		ld	e,a
+		ld	d,0
+		ex	de,hl		; DE is the labels, HL the offset
+		or	a
+		sbc	hl,bc
+		jr	nc,default
+		add	hl,bc
+		add	hl,hl
+		add	hl,de
+		jr	jump
+default:
+		ex	de,hl
+		add	hl,bc
+		add	hl,bc
+jump:
+		ld	e,(hl)
+		inc	hl
+		ld	d,(hl)
+		ex	de,hl
+		pop	bc
+		jp	(hl)
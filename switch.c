@@ -4,18 +4,131 @@
 unsigned long switch_table[NUM_SWITCH];
 unsigned long *switch_next = switch_table;
 
+/* Fewest cases worth a jump table or a binary search */
+#define SWITCH_MIN_JUMP		4
+#define SWITCH_MIN_SORTED	8
+
+/* The value as the switch compares it */
+static long switch_value(unsigned long v, unsigned type)
+{
+    if (target_sizeof(type) == 1) {
+        v &= 0xFF;
+        if (!(type & UNSIGNED) && (v & 0x80))
+            v |= ~0xFFUL;
+    } else {
+        v &= 0xFFFF;
+        if (!(type & UNSIGNED) && (v & 0x8000))
+            v |= ~0xFFFFUL;
+    }
+    return v;
+}
+
+/* Find the range of the values, or return 0 if any is repeated */
+static unsigned switch_range(unsigned long *base, unsigned type, long *low, long *high)
+{
+    unsigned long *p, *q;
+    long v;
+
+    *low = *high = switch_value(*base, type);
+    for (p = base; p < switch_next; p++) {
+        v = switch_value(*p, type);
+        if (v < *low)
+            *low = v;
+        if (v > *high)
+            *high = v;
+        for (q = base; q < p; q++)
+            if (switch_value(*q, type) == v)
+                return 0;
+    }
+    return 1;
+}
+
+/* Case number for a value or 0 for the default */
+static unsigned switch_find(unsigned long *base, unsigned type, long v)
+{
+    unsigned long *p;
+
+    for (p = base; p < switch_next; p++)
+        if (switch_value(*p, type) == v)
+            return p - base + 1;
+    return 0;
+}
+
+/* A label for every value from the lowest up, indexed by the backend */
+static void switch_jump(unsigned tag, unsigned long *base, unsigned type,
+                        long low, unsigned long span)
+{
+    unsigned long n;
+
+    header(H_SWITCHJT, tag, span);
+    put_typed_constant(type, low);
+    for (n = 0; n < span; n++)
+        put_typed_case(tag, switch_find(base, type, low + n));
+    put_typed_case(tag, 0);
+    footer(H_SWITCHJT, tag, 0);
+}
+
+/* The table in value order for a binary search. Sorting by picking the
+   next value up each time needs no extra memory */
+static void switch_sorted(unsigned tag, unsigned long *base, unsigned type,
+                          long low, long high)
+{
+    unsigned long *p;
+    unsigned long count = switch_next - base;
+    long v, next;
+
+    header(H_SWITCHBS, tag, count);
+    v = low;
+    while (count--) {
+        put_typed_constant(type, v);
+        put_typed_case(tag, switch_find(base, type, v));
+        next = high;
+        for (p = base; p < switch_next; p++) {
+            long x = switch_value(*p, type);
+            if (x > v && x < next)
+                next = x;
+        }
+        v = next;
+    }
+    put_typed_case(tag, 0);
+    footer(H_SWITCHBS, tag, 0);
+}
+
 /*
- *	When we finish a switch block off we write the table out. We could
- *	do things here like enable binary search but for now we don't and
- *	for some types it's tricky
- *	TODO;
+ *	When we finish a switch block off we write the table out. If the
+ *	backend can handle them we use a jump table when the values are
+ *	dense enough and a sorted table it can binary search when there are
+ *	enough of them, and go back and tell the switch header which. Long
+ *	switches still get searched in order.
  */
-void switch_done(unsigned tag, unsigned long *oldptr, unsigned type)
+void switch_done(unsigned tag, unsigned long *oldptr, unsigned type, unsigned long hpos)
 {
     unsigned count = 0;
     unsigned long *p = oldptr;
+    unsigned n = switch_next - oldptr;
+    unsigned forms = 0;
+    unsigned long span;
+    long low, high;
+
+    if (n >= SWITCH_MIN_JUMP && target_sizeof(type) <= 2)
+        forms = target_switch(type);
+    if (forms && switch_range(oldptr, type, &low, &high)) {
+        span = high - low + 1;
+        if ((forms & SWITCH_JUMP) && span <= 3UL * n) {
+            update_header(hpos, H_SWITCH, tag, H_SWITCHJT);
+            switch_jump(tag, oldptr, type, low, span);
+            switch_next = oldptr;
+            return;
+        }
+        if ((forms & SWITCH_SORTED) && n >= SWITCH_MIN_SORTED) {
+            update_header(hpos, H_SWITCH, tag, H_SWITCHBS);
+            switch_sorted(tag, oldptr, type, low, high);
+            switch_next = oldptr;
+            return;
+        }
+    }
 
-    header(H_SWITCHTAB, tag, switch_next - oldptr);
+    header(H_SWITCHTAB, tag, n);
     /* Table */
     while(p < switch_next) {
         put_typed_constant(type, *p++);
@@ -1,4 +1,5 @@
-extern void switch_done(unsigned tag, unsigned long *oldptr, unsigned type);
+extern void switch_done(unsigned tag, unsigned long *oldptr, unsigned type,
+			unsigned long hpos);
 extern unsigned long *switch_alloc(void);
 extern void switch_add_node(unsigned long value);
 
@@ -3,6 +3,10 @@
  *	local. To avoid two lists we keep a "last local" and "last global"
  *	pointer. This allows us to keep dumping local names whilst still
  *	being able to defines globals in local contexts.
+ *
+ *	Named symbols are also chained by name so that lookups don't walk
+ *	the whole table. The chains are in no particular order, scope is
+ *	still decided by position in the table as it always was.
  */
 
 #include <stdio.h>
@@ -16,47 +20,90 @@ struct symbol symtab[MAXSYM];
 struct symbol *last_sym = symtab - 1;
 struct symbol *local_top = symtab;
 
+/* Name ids are handed out in order by cc0 so the low bits hash well */
+#define NSYMHASH	128
+
+static unsigned symhash[NSYMHASH];	/* Index + 1 of first on chain */
+static unsigned symchain[MAXSYM];	/* Index + 1 of next on chain */
+
+static void sym_link(register struct symbol *s)
+{
+	register unsigned *h;
+	/* Anonymous and type slots are never looked up by name */
+	if (s->name == 0 || s->name == 0xFFFF)
+		return;
+	h = symhash + (s->name & (NSYMHASH - 1));
+	symchain[s - symtab] = *h;
+	*h = s - symtab + 1;
+}
+
+static void sym_unlink(register struct symbol *s)
+{
+	register unsigned *p;
+	unsigned n = s - symtab + 1;
+	if (s->name == 0 || s->name == 0xFFFF)
+		return;
+	p = symhash + (s->name & (NSYMHASH - 1));
+	while (*p) {
+		if (*p == n) {
+			*p = symchain[n - 1];
+			return;
+		}
+		p = symchain + *p - 1;
+	}
+}
+
 struct symbol *symbol_ref(unsigned type)
 {
 	return symtab + INFO(type);
 }
 
-/* Local symbols have priority in all cases */
+/* Local symbols have priority in all cases. The highest local in the
+   table is the innermost, if there is no local the lowest global wins */
 /* Find a symbol in the normal name space */
 struct symbol *find_symbol(unsigned name, unsigned global)
 {
-	register struct symbol *s = last_sym;
+	register struct symbol *s;
+	register unsigned n = symhash[name & (NSYMHASH - 1)];
+	struct symbol *lmatch = NULL;
 	struct symbol *gmatch = NULL;
-	/* Walk backwards so that the first local we find is highest priority
-	   by scope */
-	while (s >= symtab) {
+
+	while (n) {
+		s = symtab + n - 1;
 		if (s->name == name && s->infonext < S_TYPEDEF) {
 			if (s->infonext < S_STATIC) {
-				if (!global)
-					return s;
-			} else	/* Still need to look for a local */
+				if (!global && s > lmatch)
+					lmatch = s;
+			} else if (gmatch == NULL || s < gmatch)
 				gmatch = s;
 		}
-		s--;
+		n = symchain[n - 1];
 	}
+	if (lmatch)
+		return lmatch;
 	return gmatch;
 }
 
 struct symbol *find_symbol_by_class(unsigned name, unsigned class)
 {
-	register struct symbol *s = last_sym;
+	register struct symbol *s;
+	register unsigned n = symhash[name & (NSYMHASH - 1)];
+	struct symbol *lmatch = NULL;
 	struct symbol *gmatch = NULL;
-	/* Walk backwards so that the first local we find is highest priority
-	   by scope */
-	while (s >= symtab) {
+
+	while (n) {
+		s = symtab + n - 1;
 		if (s->name == name && S_STORAGE(s->infonext) == class) {
-			if (s->infonext < S_STATIC)
-				return s;
-			else	/* Still need to look for a local */
+			if (s->infonext < S_STATIC) {
+				if (s > lmatch)
+					lmatch = s;
+			} else if (gmatch == NULL || s < gmatch)
 				gmatch = s;
 		}
-		s--;
+		n = symchain[n - 1];
 	}
+	if (lmatch)
+		return lmatch;
 	return gmatch;
 }
 
@@ -67,6 +114,7 @@ void pop_local_symbols(struct symbol *top)
 		if (S_STORAGE(s->infonext) < S_STATIC) {
 			/* Write out any storage if needed */
 			symbol_bss(s);
+			sym_unlink(s);
 			s->infonext = S_FREE;
 			s->name = 0;
 		}
@@ -86,13 +134,15 @@ struct symbol *mark_local_symbols(void)
 struct symbol *alloc_symbol(unsigned name, unsigned local)
 {
 	register struct symbol *s = local_top;
-	while (s <= &symtab[MAXSYM]) {
+	while (s < &symtab[MAXSYM]) {
 		if (s->infonext == S_FREE) {
 			if (local && local_top < s)
 				local_top = s;
 			if (last_sym < s)
 				last_sym = s;
+			sym_unlink(s);
 			s->name = name;
+			sym_link(s);
 			s->data.idx = 0;
 			return s;
 		}
@@ -317,19 +367,23 @@ unsigned array_compatible(unsigned t1, unsigned t2)
 
 static struct symbol *find_struct(unsigned name)
 {
-	struct symbol *sym = symtab;
+	register struct symbol *sym;
+	register unsigned n = symhash[name & (NSYMHASH - 1)];
+	struct symbol *match = NULL;
 	/* Anonymous structs are unique each time */
 	if (name == 0)
 		return 0;
-	while(sym <= last_sym) {
-		if (sym->name == name) {
+	/* First declared wins */
+	while (n) {
+		sym = symtab + n - 1;
+		if (sym->name == name && (match == NULL || sym < match)) {
 			unsigned st = S_STORAGE(sym->infonext);
 			if (st == S_STRUCT || st == S_UNION)
-				return sym;
+				match = sym;
 		}
-		sym++;
+		n = symchain[n - 1];
 	}
-	return NULL;
+	return match;
 }
 
 struct symbol *update_struct(unsigned name, unsigned t)
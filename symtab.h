@@ -1,4 +1,11 @@
+#include "host.h"
+
+/* Hosted builds have the memory for a much bigger name table */
+#ifdef HOSTED
+#define MAXNAME		8192
+#else
 #define MAXNAME		1024
+#endif
 
 #define	NAMELEN		16	/* 15 usable due to _ lead on C names */
 
@@ -108,3 +108,8 @@ void target_reginit(void)
 {
 	rused = 0;
 }
+
+unsigned target_switch(unsigned t)
+{
+	return 0;
+}
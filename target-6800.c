@@ -116,3 +116,26 @@ void target_reginit(void)
 {
 	u_free = 1;
 }
+
+/* U goes to a busy variable unless "register" took it. Maths on an int is
+   as quick from the stack as from U so only give it to pointers, which gain
+   indexing through U */
+unsigned target_autoreg(unsigned type)
+{
+	if (PTR(type))
+		return target_register(type, S_AUTO);
+	return 0;
+}
+
+/* Only the 6809 has the jump table and binary search helpers so far */
+unsigned target_switch(unsigned t)
+{
+	unsigned s = target_sizeof(t);
+	if (cputype != 6809)
+		return 0;
+	if (s == 1)
+		return SWITCH_JUMP;
+	if (s == 2)
+		return SWITCH_JUMP | SWITCH_SORTED;
+	return 0;
+}
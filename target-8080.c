@@ -113,3 +113,21 @@ void target_reginit(void)
 {
 	bc_free = 1;
 }
+
+/* If nobody asked for BC then it goes to a busy variable */
+unsigned target_autoreg(unsigned type)
+{
+	return target_register(type, S_AUTO);
+}
+
+/* The support library has jump table helpers for 8 and 16bit values and
+   binary searches for 16bit ones */
+unsigned target_switch(unsigned t)
+{
+	unsigned s = target_sizeof(t);
+	if (s == 1)
+		return SWITCH_JUMP;
+	if (s == 2)
+		return SWITCH_JUMP | SWITCH_SORTED;
+	return 0;
+}
@@ -126,3 +126,7 @@ void target_reginit(void)
 	di_free = 1;
 }
 
+unsigned target_switch(unsigned t)
+{
+	return 0;
+}
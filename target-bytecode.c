@@ -99,3 +99,8 @@ unsigned target_register(unsigned type, unsigned storage)
 void target_reginit(void)
 {
 }
+
+unsigned target_switch(unsigned t)
+{
+	return 0;
+}
@@ -123,3 +123,8 @@ void target_reginit(void)
 	z_free = 1;
 #endif
 }
+
+unsigned target_switch(unsigned t)
+{
+	return 0;
+}
@@ -107,3 +107,8 @@ void target_reginit(void)
 {
 	bc_free = 1;
 }
+
+unsigned target_switch(unsigned t)
+{
+	return 0;
+}
@@ -136,3 +136,21 @@ void target_reginit(void)
 	if (!(cpufeat & 4))	/* --no-iy */
 		iy_free = 1;
 }
+
+/* Whatever "register" left goes to the busiest variables the same way */
+unsigned target_autoreg(unsigned type)
+{
+	return target_register(type, S_AUTO);
+}
+
+/* As on the 8080 switches can use jump tables of 8 and 16bit values and
+   binary searches of 16bit ones */
+unsigned target_switch(unsigned t)
+{
+	unsigned s = target_sizeof(t);
+	if (s == 1)
+		return SWITCH_JUMP;
+	if (s == 2)
+		return SWITCH_JUMP | SWITCH_SORTED;
+	return 0;
+}
@@ -19,6 +19,12 @@ extern unsigned target_remove_cast(struct node *l, struct node *r);
 extern unsigned target_type_remap(unsigned t);
 extern unsigned target_register(unsigned t, unsigned s);
 extern void target_reginit(void);
+/* A register "register" left for a busy variable of this type, or 0 */
+extern unsigned target_autoreg(unsigned t);
+/* Switch table forms the backend can dispatch besides searching in order */
+#define SWITCH_JUMP	1	/* Indexed by value */
+#define SWITCH_SORTED	2	/* Binary searched */
+extern unsigned target_switch(unsigned t);
 
 /* Default integer type is 2 byte */
 #define CINT	CSHORT
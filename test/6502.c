@@ -977,6 +977,11 @@ uint16_t getPC(void)
 	return (pc);
 }
 
+uint8_t getSP(void)
+{
+	return (sp);
+}
+
 uint64_t getclockticks(void)
 {
 	return (clockticks6502);
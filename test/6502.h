@@ -9,6 +9,7 @@ extern uint64_t exec6502(uint64_t tickcount);
 extern void step6502(void);
 extern void hookexternal(void (*loopexternal)(void));
 extern uint16_t getPC(void);
+extern uint8_t getSP(void);
 extern uint64_t getclockticks(void);
 extern void waitstates(uint32_t n);
 
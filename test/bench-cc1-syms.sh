@@ -0,0 +1,60 @@
+#!/bin/sh
+#
+#	Time cc1 on a header heavy generated source. Most of the tokens are
+#	declarations so this is mostly symbol and typedef lookup. Run from
+#	the test directory after building the compiler and syscount.
+#
+#	bench-cc1-syms.sh [cpu] [declarations] [functions] [statements]
+#
+CPU=${1:-z80}
+N=${2:-200}
+F=${3:-60}
+S=${4:-40}
+LIB=${LIB:-..}
+T=${TMPDIR:-/tmp}/bench-cc1.$$
+
+case $CPU in
+z80)	CODE=80;;
+*)	CODE=$CPU;;
+esac
+
+trap 'rm -f $T.c $T.cc0 $T.sym $T.cc1' 0
+
+i=0
+{
+	while [ $i -lt $N ]
+	do
+		echo "typedef unsigned int type$i;"
+		echo "extern type$i value$i;"
+		echo "extern char *name$i;"
+		echo "extern int func$i(type$i, char *);"
+		i=$((i + 1))
+	done
+	i=0
+	while [ $i -lt $F ]
+	do
+		a=$((i * 7 % N))
+		b=$((i * 13 % N))
+		echo "int body$i(type$a x)"
+		echo "{"
+		echo "	type$b y = value$b;"
+		echo "	char *r = name$a;"
+		echo "	type$a z;"
+		j=0
+		while [ $j -lt $S ]
+		do
+			c=$(((i * 11 + j * 17) % N))
+			echo "	{ type$c w = value$c; y += func$c(w, name$c) + (type$a)w; }"
+			j=$((j + 1))
+		done
+		echo "	for (z = 0; z < x; z++)"
+		echo "		y += func$a(z, r) + value$a;"
+		echo "	return func$b(y, name$b);"
+		echo "}"
+		i=$((i + 1))
+	done
+} >$T.c
+
+$LIB/cc0 $T.sym <$T.c >$T.cc0 || exit 1
+echo "cc1.$CPU: $N declarations, $F functions"
+./syscount $LIB/cc1.$CPU $CODE 0 <$T.cc0 1<>$T.cc1
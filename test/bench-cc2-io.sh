@@ -0,0 +1,58 @@
+#!/bin/sh
+#
+#	Count the read system calls cc2 makes on a large generated source.
+#	Run from the test directory after building the compiler and
+#	syscount.
+#
+#	bench-cc2-io.sh [cpu] [functions] [externs]
+#
+#	With externs set each function also uses a few of that many extern
+#	variables, which is what stresses the cc2 name lookup.
+#
+CPU=${1:-z80}
+N=${2:-400}
+E=${3:-0}
+LIB=${LIB:-..}
+T=${TMPDIR:-/tmp}/bench-cc2.$$
+
+case $CPU in
+z80)	CODE=80;;
+*)	CODE=$CPU;;
+esac
+
+trap 'rm -f $T.c $T.cc0 $T.sym $T.cc1 $T.s' 0
+
+i=0
+{
+	echo "int g[16];"
+	echo "char *msg;"
+	j=0
+	while [ $j -lt $E ]
+	do
+		echo "extern int e$j;"
+		j=$((j + 1))
+	done
+	while [ $i -lt $N ]
+	do
+		echo "int f$i(int a, int b, int *p)"
+		echo "{"
+		echo "	int x = a * 3 + b - g[$((i % 16))];"
+		echo "	while (x < b * 7 + (a & 255)) {"
+		echo "		x = x + *p++ - (a >> 1) + (b ^ $i);"
+		echo "		g[x & 15] = x | a;"
+		echo "	}"
+		echo "	msg = \"function $i has a string literal of some length\";"
+		if [ $E -gt 0 ]
+		then
+			echo "	e$((i % E)) = e$(((i * 7 + 1) % E)) + e$(((i * 13 + 2) % E));"
+			echo "	x += e$(((i * 17 + 3) % E)) - e$(((i * 31 + 4) % E));"
+		fi
+		echo "	return x + a * b - $i;"
+		echo "}"
+		i=$((i + 1))
+	done
+} >$T.c
+
+$LIB/cc0 $T.sym <$T.c >$T.cc0 && $LIB/cc1.$CPU $CODE 0 <$T.cc0 1<>$T.cc1 || exit 1
+echo "cc2.$CPU: $N functions, $(wc -c <$T.cc1) bytes of input"
+./syscount $LIB/cc2.$CPU $T.sym $CODE 0 0 <$T.cc1 >$T.s
@@ -0,0 +1,67 @@
+#!/bin/sh
+#
+#	Compare two run-bench.sh results kernel by kernel
+#
+#	bench-compare.sh base.csv new.csv
+#
+#	Exits non zero if a kernel failed or got slower or larger by more
+#	than SLACK percent (default 0)
+#
+if [ $# != 2 ]; then
+	echo "bench-compare.sh base.csv new.csv" >&2
+	exit 1
+fi
+
+awk -F, -v slack=${SLACK:-0} '
+function pct(o, n) {
+	if (o == 0)
+		return 0
+	return (n - o) * 100.0 / o
+}
+
+FNR == 1 { next }
+
+NR == FNR {
+	cyc[$1 "," $2 "," $3] = $4
+	sz[$1 "," $2 "," $3] = $5
+	next
+}
+
+{
+	k = $1 "," $2 "," $3
+	if ($6 != "ok") {
+		v = "FAIL(" $6 ")"
+		bad++
+	} else if (!(k in cyc) || cyc[k] == "") {
+		v = "new"
+	} else {
+		c = pct(cyc[k], $4)
+		s = pct(sz[k], $5)
+		v = ""
+		if (c > slack) {
+			v = v " slower"
+			bad++
+		} else if (c < -slack)
+			v = v " faster"
+		if (s > slack) {
+			v = v " larger"
+			bad++
+		} else if (s < -slack)
+			v = v " smaller"
+		if (v == "")
+			v = " same"
+		tc += cyc[k]
+		tn += $4
+		v = sprintf("%10s %10s %+7.2f%% %6s %6s %+7.2f%%%s",
+			cyc[k], $4, c, sz[k], $5, s, v)
+	}
+	printf("%-5s %-3s %-10s %s\n", $1, $2, $3, v)
+}
+
+END {
+	printf("total cycles %d -> %d (%+.2f%%)\n", tc, tn, pct(tc, tn))
+	if (bad) {
+		printf("%d regressions or failures\n", bad)
+		exit 1
+	}
+}' "$1" "$2"
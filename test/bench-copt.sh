@@ -0,0 +1,46 @@
+#!/bin/sh
+#
+#	Time copt, reading all of the input first and streaming, on a large
+#	generated assembler file. Run from the test directory after building
+#	the compiler and syscount.
+#
+#	bench-copt.sh [cpu] [functions]
+#
+CPU=${1:-z80}
+N=${2:-400}
+LIB=${LIB:-..}
+T=${TMPDIR:-/tmp}/bench-copt.$$
+
+case $CPU in
+z80)	CODE=80;;
+*)	CODE=$CPU;;
+esac
+
+trap 'rm -f $T.c $T.cc0 $T.sym $T.cc1 $T.s' 0
+
+i=0
+{
+	echo "int g[16];"
+	while [ $i -lt $N ]
+	do
+		echo "int f$i(int a, int b, int *p)"
+		echo "{"
+		echo "	int x = a * 3 + b - g[$((i % 16))];"
+		echo "	while (x < b * 7 + (a & 255)) {"
+		echo "		x = x + *p++ - (a >> 1) + (b ^ $i);"
+		echo "		g[x & 15] = x | a;"
+		echo "		if (x == $i || p[1] == a)"
+		echo "			return x - a;"
+		echo "	}"
+		echo "	return x + a * b - $i;"
+		echo "}"
+		i=$((i + 1))
+	done
+} >$T.c
+
+$LIB/cc0 $T.sym <$T.c >$T.cc0 && $LIB/cc1.$CPU $CODE 0 <$T.cc0 1<>$T.cc1 &&
+	$LIB/cc2.$CPU $T.sym $CODE 2 0 <$T.cc1 >$T.s || exit 1
+echo "copt rules.$CPU: $(wc -l <$T.s) lines"
+./syscount $LIB/copt $LIB/rules.$CPU <$T.s >/dev/null
+echo "copt -s rules.$CPU:"
+./syscount $LIB/copt -s $LIB/rules.$CPU <$T.s >/dev/null
@@ -0,0 +1,35 @@
+#
+#	Included by run-bench.sh and size-report.sh. Sets LINK, LIBS and
+#	EMU for the test programs of a target, linked as the run-test
+#	scripts do.
+#
+FCCLIB=${FCCLIB:-/opt/fcc/lib}
+
+# Set the link line and emulator for a target
+target()
+{
+	case $1 in
+	z80)	LINK="ldz80 -b -C0 testcrtz80.o"
+		LIBS="$FCCLIB/z80/libz80.a"
+		EMU="./emuz80 -c";;
+	8080|8085)
+		LINK="ld8080 -b -C0 testcrt0_8080.o"
+		LIBS="$FCCLIB/$1/lib$1.a"
+		EMU="./emu85 -c";;
+	6502)	LINK="ld6502 -b -C512 testcrt0_6502.o"
+		LIBS="$FCCLIB/6502/lib6502.a"
+		EMU="./emu6502 -c";;
+	6800)	LINK="ld6800 -b -C256 -Z0 testcrt0_6800.o"
+		LIBS="$FCCLIB/6800/lib6800.a $FCCLIB/6800/libc.a"
+		EMU="./emu6800 -c 6800";;
+	6803|6303)
+		LINK="ld6800 -b -C256 -Z64 testcrt0_$1.o"
+		LIBS="$FCCLIB/$1/lib$1.a"
+		EMU="./emu6800 -c $1";;
+	6809)	LINK="ld6809 -b -C512 testcrt0_6809.o"
+		LIBS="$FCCLIB/6809/lib6809.a"
+		EMU="./emu6809 -c";;
+	*)	echo "no emulator for $1" >&2
+		return 1;;
+	esac
+}
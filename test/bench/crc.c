@@ -0,0 +1,66 @@
+/*
+ *	CRC16 (CCITT) and CRC32 bit at a time, the usual shape of checksum
+ *	code in disk and network drivers.
+ */
+
+static unsigned char buf[256];
+
+static unsigned short crc16(unsigned short crc, const unsigned char *p, unsigned n)
+{
+    unsigned char i;
+    while (n--) {
+        crc ^= *p++ << 8;
+        for (i = 0; i < 8; i++) {
+            if (crc & 0x8000)
+                crc = (crc << 1) ^ 0x1021;
+            else
+                crc <<= 1;
+        }
+    }
+    return crc;
+}
+
+static unsigned long crc32(unsigned long crc, const unsigned char *p, unsigned n)
+{
+    unsigned char i;
+    crc = ~crc;
+    while (n--) {
+        crc ^= *p++;
+        for (i = 0; i < 8; i++) {
+            if (crc & 1)
+                crc = (crc >> 1) ^ 0xEDB88320UL;
+            else
+                crc >>= 1;
+        }
+    }
+    return ~crc;
+}
+
+int main(int argc, char *argv[])
+{
+    static const unsigned char check[] = "123456789";
+    unsigned i;
+    unsigned short c16;
+    unsigned long c32;
+
+    if (crc16(0xFFFF, check, 9) != 0x29B1)
+        return 1;
+    if (crc32(0, check, 9) != 0xCBF43926UL)
+        return 2;
+
+    for (i = 0; i < 256; i++)
+        buf[i] = i;
+    /* Running the CRC over the pieces gives the CRC of the whole */
+    c32 = crc32(0, buf, 256);
+    if (crc32(crc32(0, buf, 100), buf + 100, 156) != c32)
+        return 3;
+    c16 = crc16(0xFFFF, buf, 256);
+    if (crc16(crc16(0xFFFF, buf, 100), buf + 100, 156) != c16)
+        return 4;
+    /* The CRC of the data followed by its CRC is zero */
+    buf[0] = c16 >> 8;
+    buf[1] = c16;
+    if (crc16(c16, buf, 2) != 0)
+        return 5;
+    return 0;
+}
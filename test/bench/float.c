@@ -0,0 +1,46 @@
+/*
+ *	Float arithmetic through the soft float helpers: Newton square
+ *	roots, a series sum and polynomial evaluation.
+ */
+
+static float fsqrt(float x)
+{
+    float r = x / 2;
+    unsigned char i;
+    for (i = 0; i < 8; i++)
+        r = (r + x / r) / 2;
+    return r;
+}
+
+static float poly(float x)
+{
+    /* 1 + x + x^2/2 + x^3/6 + x^4/24 */
+    return 1 + x * (1 + x * (0.5 + x * (0.16666667 + x * 0.041666668)));
+}
+
+static int near(float a, float b)
+{
+    float d = a - b;
+    return d > -0.001 && d < 0.001;
+}
+
+int main(int argc, char *argv[])
+{
+    float s = 0;
+    unsigned i;
+
+    if (!near(fsqrt(2.0), 1.4142135))
+        return 1;
+    if (!near(fsqrt(10.0), 3.1622777))
+        return 2;
+    /* Sum of 1/i^2 heads for pi^2/6 */
+    for (i = 1; i <= 100; i++)
+        s += 1.0 / ((float)i * i);
+    if (s < 1.63 || s > 1.64)
+        return 3;
+    if (!near(poly(0.5), 1.6484375))
+        return 4;
+    if (!near(poly(-1.0), 0.375))
+        return 5;
+    return 0;
+}
@@ -0,0 +1,56 @@
+/*
+ *	32bit arithmetic: multiply, divide, remainder and shifts through the
+ *	runtime helpers.
+ */
+
+static unsigned long isqrt(unsigned long n)
+{
+    unsigned long x = n;
+    unsigned long y = (x + 1) >> 1;
+    while (y < x) {
+        x = y;
+        y = (x + n / x) >> 1;
+    }
+    return x;
+}
+
+static unsigned long gcd(unsigned long a, unsigned long b)
+{
+    unsigned long t;
+    while (b) {
+        t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long sum = 0;
+    unsigned long n, q, r;
+    long s = 0;
+    unsigned i;
+
+    for (i = 0; i < 200; i++)
+        sum += (unsigned long)i * i;
+    if (sum != 2646700UL)
+        return 1;
+
+    for (i = 1; i < 100; i++) {
+        n = 1234567UL * i + 89;
+        q = n / (i + 7);
+        r = n % (i + 7);
+        if (q * (i + 7) + r != n || r >= i + 7)
+            return 2;
+        s -= (long)(n >> (i & 15));
+        s += (long)(r << (i & 7));
+    }
+    if (s >= 0)
+        return 3;
+    if (isqrt(1000000000UL) != 31622UL)
+        return 4;
+    if (gcd(1071UL * 65537UL, 462UL * 65537UL) != 21UL * 65537UL)
+        return 5;
+    return 0;
+}
@@ -0,0 +1,79 @@
+/*
+ *	A generic quicksort through a comparison function pointer on a
+ *	pseudo random array, then a check it came out sorted.
+ */
+
+#define N	200
+
+static int data[N];
+
+static int cmp_int(const void *a, const void *b)
+{
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    if (x < y)
+        return -1;
+    return x > y;
+}
+
+static void swap(char *a, char *b, unsigned size)
+{
+    char t;
+    while (size--) {
+        t = *a;
+        *a++ = *b;
+        *b++ = t;
+    }
+}
+
+static void sort(char *base, unsigned n, unsigned size,
+                 int (*cmp)(const void *, const void *))
+{
+    char *pivot;
+    unsigned i, last;
+
+    while (n > 1) {
+        /* Middle element as pivot, moved to the front */
+        swap(base, base + (n / 2) * size, size);
+        pivot = base;
+        last = 0;
+        for (i = 1; i < n; i++) {
+            if (cmp(base + i * size, pivot) < 0) {
+                last++;
+                swap(base + last * size, base + i * size, size);
+            }
+        }
+        swap(base, base + last * size, size);
+        /* Recurse on the smaller side, loop on the larger */
+        if (last < n - last - 1) {
+            sort(base, last, size, cmp);
+            base += (last + 1) * size;
+            n -= last + 1;
+        } else {
+            sort(base + (last + 1) * size, n - last - 1, size, cmp);
+            n = last;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned short seed = 1;
+    unsigned sum = 0, check = 0;
+    unsigned i;
+
+    for (i = 0; i < N; i++) {
+        seed = seed * 25173U + 13849U;
+        data[i] = (int)(seed >> 1) - 16384;
+        sum += data[i];
+    }
+    sort((char *)data, N, sizeof(int), cmp_int);
+    for (i = 0; i < N; i++) {
+        if (i && data[i - 1] > data[i])
+            return 1;
+        check += data[i];
+    }
+    if (check != sum)
+        return 2;
+    return 0;
+}
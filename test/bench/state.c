@@ -0,0 +1,160 @@
+/*
+ *	A switch driven state machine: a small tokenizer run over a block
+ *	of C like text, counting each kind of token.
+ */
+
+#define S_SPACE		0
+#define S_IDENT		1
+#define S_NUMBER	2
+#define S_HEX		3
+#define S_STRING	4
+#define S_ESCAPE	5
+#define S_SLASH		6
+#define S_COMMENT	7
+#define S_STAR		8
+
+static const char text[] =
+    "int main(int argc, char *argv[])\n"
+    "{\n"
+    "\t/* Say hello */\n"
+    "\tint x = 0x1F + 42 * argc;\n"
+    "\tprintf(\"hello \\\"world\\\" %d\\n\", x / 2);\n"
+    "\treturn x != 7 ? 0 : 1;\n"
+    "}\n";
+
+static unsigned counts[6];
+#define C_IDENT		0
+#define C_NUMBER	1
+#define C_STRING	2
+#define C_COMMENT	3
+#define C_OP		4
+#define C_LINE		5
+
+static unsigned char class(char c)
+{
+    switch (c) {
+    case ' ':
+    case '\t':
+        return 0;
+    case '\n':
+        return 1;
+    case '0': case '1': case '2': case '3': case '4':
+    case '5': case '6': case '7': case '8': case '9':
+        return 2;
+    case '_':
+        return 3;
+    case '"':
+        return 4;
+    case '/':
+        return 5;
+    case '*':
+        return 6;
+    case '\\':
+        return 7;
+    default:
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+            return 3;
+        return 8;
+    }
+}
+
+static void scan(const char *p)
+{
+    unsigned char state = S_SPACE;
+    unsigned char c;
+
+    while (*p) {
+        c = class(*p);
+        switch (state) {
+        case S_IDENT:
+            if (c == 2 || c == 3)
+                break;
+            state = S_SPACE;
+            continue;
+        case S_NUMBER:
+            if (c == 2)
+                break;
+            if (*p == 'x' || *p == 'X') {
+                state = S_HEX;
+                break;
+            }
+            state = S_SPACE;
+            continue;
+        case S_HEX:
+            if (c == 2 || (*p >= 'A' && *p <= 'F') || (*p >= 'a' && *p <= 'f'))
+                break;
+            state = S_SPACE;
+            continue;
+        case S_STRING:
+            if (c == 7)
+                state = S_ESCAPE;
+            else if (c == 4)
+                state = S_SPACE;
+            break;
+        case S_ESCAPE:
+            state = S_STRING;
+            break;
+        case S_SLASH:
+            if (c == 6) {
+                state = S_COMMENT;
+                counts[C_COMMENT]++;
+                break;
+            }
+            counts[C_OP]++;
+            state = S_SPACE;
+            continue;
+        case S_COMMENT:
+            if (c == 6)
+                state = S_STAR;
+            break;
+        case S_STAR:
+            if (c == 5)
+                state = S_SPACE;
+            else if (c != 6)
+                state = S_COMMENT;
+            break;
+        default:
+            switch (c) {
+            case 0:
+                break;
+            case 1:
+                counts[C_LINE]++;
+                break;
+            case 2:
+                counts[C_NUMBER]++;
+                state = S_NUMBER;
+                break;
+            case 3:
+                counts[C_IDENT]++;
+                state = S_IDENT;
+                break;
+            case 4:
+                counts[C_STRING]++;
+                state = S_STRING;
+                break;
+            case 5:
+                state = S_SLASH;
+                break;
+            default:
+                counts[C_OP]++;
+                break;
+            }
+        }
+        p++;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned i;
+
+    for (i = 0; i < 10; i++)
+        scan(text);
+    if (counts[C_IDENT] != 130 || counts[C_NUMBER] != 60)
+        return 1;
+    if (counts[C_STRING] != 10 || counts[C_COMMENT] != 10)
+        return 2;
+    if (counts[C_OP] != 220 || counts[C_LINE] != 70)
+        return 3;
+    return 0;
+}
@@ -0,0 +1,83 @@
+/*
+ *	String and memory loops of the kind the C library and the kernel
+ *	spend their time in.
+ */
+
+static char src[128];
+static char dst[128];
+
+static unsigned my_strlen(const char *p)
+{
+    const char *s = p;
+    while (*p)
+        p++;
+    return p - s;
+}
+
+static char *my_strcpy(char *d, const char *s)
+{
+    char *r = d;
+    while ((*d++ = *s++) != 0);
+    return r;
+}
+
+static int my_strcmp(const char *a, const char *b)
+{
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return *(unsigned char *)a - *(unsigned char *)b;
+}
+
+static void my_memset(void *p, int c, unsigned n)
+{
+    char *d = p;
+    while (n--)
+        *d++ = c;
+}
+
+static void my_memcpy(void *dp, const void *sp, unsigned n)
+{
+    char *d = dp;
+    const char *s = sp;
+    while (n--)
+        *d++ = *s++;
+}
+
+static char *my_strchr(const char *p, int c)
+{
+    while (*p) {
+        if (*p == c)
+            return (char *)p;
+        p++;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned i, n;
+    unsigned total = 0;
+
+    for (i = 0; i < 120; i++)
+        src[i] = 'A' + i % 26;
+    src[120] = 0;
+
+    for (n = 0; n < 20; n++) {
+        my_memset(dst, 0, sizeof(dst));
+        my_strcpy(dst, src);
+        total += my_strlen(dst);
+        if (my_strcmp(dst, src))
+            return 1;
+        dst[100] = 'a';
+        if (my_strcmp(dst, src) <= 0)
+            return 2;
+        my_memcpy(dst, src + 60, 60);
+        if (my_strchr(dst, 'Z') != dst + 17)
+            return 3;
+    }
+    if (total != 2400)
+        return 4;
+    return 0;
+}
@@ -0,0 +1,25 @@
+#!/bin/sh
+#
+#	Check that copt gives the same output streaming (-s) as it does
+#	reading the whole file first. Feed it unoptimized compiler output.
+#
+#	copt-stream.sh rules file.s...
+#
+COPT=${COPT:-$(dirname $0)/../copt}
+RULES=$1
+shift
+T=${TMPDIR:-/tmp}/copt-stream.$$
+trap 'rm -f $T.a $T.b' 0
+
+err=0
+for i in "$@"
+do
+	$COPT $RULES <$i >$T.a 2>&1
+	$COPT -s $RULES <$i >$T.b 2>&1
+	if ! cmp -s $T.a $T.b
+	then
+		echo "$i: streaming output differs"
+		err=1
+	fi
+done
+exit $err
@@ -12,6 +12,7 @@
 #include <fcntl.h>
 
 #include "6502.h"
+#include "profile.h"
 
 static uint8_t ram[65536];
 
@@ -45,16 +46,41 @@ void write6502(uint16_t addr, uint8_t val)
     }
 }
 
+/* -c: report the cycles used when the test exits */
+static unsigned counting;
+/* -p: report the cycles used by each function in the map */
+static unsigned profiling;
+
+static void report_cycles(void)
+{
+    fprintf(stderr, "CPU cycles = %lu\n", (unsigned long)getclockticks());
+}
+
+/* Called after each instruction. JSR stacks the address of its last byte */
+static void profile_hook(void)
+{
+    uint16_t s = 0x100 + getSP();
+    profile_step(getPC(), s, getclockticks(),
+        (ram[0x100 + (uint8_t)(s + 1)] | (ram[0x100 + (uint8_t)(s + 2)] << 8)) + 1);
+}
+
 int main(int argc, char *argv[])
 {
     int fd;
-    if (argc == 4 && strcmp(argv[1], "-d") == 0) {
+    while (argc > 1 && *argv[1] == '-') {
+        if (strcmp(argv[1], "-d") == 0)
+            log_6502 = 1;
+        else if (strcmp(argv[1], "-c") == 0)
+            counting = 1;
+        else if (strcmp(argv[1], "-p") == 0)
+            profiling = 1;
+        else
+            break;
         argv++;
         argc--;
-        log_6502 = 1;
     }
     if (argc != 3) {
-        fprintf(stderr, "emu6502: test map.\n");
+        fprintf(stderr, "emu6502: [-d] [-c] [-p] test map.\n");
         exit(1);
     }
     fd = open(argv[1], O_RDONLY);
@@ -77,6 +103,14 @@ int main(int argc, char *argv[])
     disassembler_init(argv[2]);
     init6502();
     reset6502();
+    if (counting)
+        atexit(report_cycles);
+    if (profiling) {
+        profile_load(argv[2]);
+        atexit(profile_report);
+        hookexternal(profile_hook);
+        profile_hook();
+    }
 
     while(1)
         exec6502(100000);
@@ -117,19 +117,32 @@ void m6800_write(struct m6800 *cpu, uint16_t addr, uint8_t val)
 	}
 }
 
+/* -c: report the cycles used when the test exits */
+static unsigned counting;
+
+static void report_cycles(void)
+{
+	fprintf(stderr, "CPU cycles = %lu\n", cycles);
+}
+
 /* TODO: CPU setting option */
 int main(int argc, char *argv[])
 {
 	int fd;
 	unsigned debug = 0;
 
-	if (argc == 5 && strcmp(argv[1], "-d") == 0) {
-		debug = 1;
+	while (argc > 1 && *argv[1] == '-') {
+		if (strcmp(argv[1], "-d") == 0)
+			debug = 1;
+		else if (strcmp(argv[1], "-c") == 0)
+			counting = 1;
+		else
+			break;
 		argv++;
 		argc--;
 	}
 	if (argc != 4) {
-		fprintf(stderr, "emu6800: cpu test map.\n");
+		fprintf(stderr, "emu6800: [-d] [-c] cpu test map.\n");
 		exit(1);
 	}
 	fd = open(argv[2], O_RDONLY);
@@ -148,6 +161,8 @@ int main(int argc, char *argv[])
 	/* Run from 0x100 */
 	ram[0xFFFE] = 0x01;
 	ram[0xFFFF] = 0x00;
+	if (counting)
+		atexit(report_cycles);
 	switch(atoi(argv[1])) {
 	case 6303:
 		m6800_reset(&cpu, CPU_6303, INTIO_6803, 3);
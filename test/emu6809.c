@@ -92,17 +92,32 @@ void e6809_instruction(unsigned pc)
 	}
 }
 
+static unsigned long cycles;
+
+/* -c: report the cycles used when the test exits */
+static unsigned counting;
+
+static void report_cycles(void)
+{
+	fprintf(stderr, "CPU cycles = %lu\n", cycles);
+}
+
 int main(int argc, char *argv[])
 {
 	int fd;
 
-	if (argc == 4 && strcmp(argv[1], "-d") == 0) {
+	while (argc > 1 && *argv[1] == '-') {
+		if (strcmp(argv[1], "-d") == 0)
+			log_6809 = 1;
+		else if (strcmp(argv[1], "-c") == 0)
+			counting = 1;
+		else
+			break;
 		argv++;
 		argc--;
-		log_6809 = 1;
 	}
 	if (argc != 3) {
-		fprintf(stderr, "emu6809: test map.\n");
+		fprintf(stderr, "emu6809: [-d] [-c] test map.\n");
 		exit(1);
 	}
 	fd = open(argv[1], O_RDONLY);
@@ -122,7 +137,9 @@ int main(int argc, char *argv[])
 	ram[0xFFFF] = 0x00;
 
 	e6809_reset(log_6809);
+	if (counting)
+		atexit(report_cycles);
 	while (1)
-		e6809_sstep(0, 0);
+		cycles += e6809_sstep(0, 0);
 	return 0;
 }
@@ -10,8 +10,10 @@
 #include <fcntl.h>
 
 #include "intel_8085_emulator.h"
+#include "profile.h"
 
 static uint8_t ram[65536];
+static unsigned long cycles;
 
 uint8_t i8085_read(uint16_t addr)
 {
@@ -72,16 +74,40 @@ void i8085_set_output(int value)
 {
 }
 
+/* -c: report the cycles used when the test exits */
+static unsigned counting;
+/* -p: report the cycles used by each function in the map */
+static unsigned profiling;
+
+static void report_cycles(void)
+{
+    fprintf(stderr, "CPU cycles = %lu\n", cycles);
+}
+
+static void profile_state(void)
+{
+    uint16_t sp = i8085_read_reg16(SP);
+    profile_step(i8085_read_reg16(PC), sp, cycles,
+        ram[sp] | (ram[(uint16_t)(sp + 1)] << 8));
+}
+
 int main(int argc, char *argv[])
 {
     int fd;
-    if (argc == 4 && strcmp(argv[1], "-d") == 0) {
+    while (argc > 1 && *argv[1] == '-') {
+        if (strcmp(argv[1], "-d") == 0)
+            i8085_log = stderr;
+        else if (strcmp(argv[1], "-c") == 0)
+            counting = 1;
+        else if (strcmp(argv[1], "-p") == 0)
+            profiling = 1;
+        else
+            break;
         argv++;
         argc--;
-        i8085_log = stderr;
     }
     if (argc != 3) {
-        fprintf(stderr, "emu85: test map.\n");
+        fprintf(stderr, "emu85: [-d] [-c] [-p] test map.\n");
         exit(1);
     }
     fd = open(argv[1], O_RDONLY);
@@ -97,6 +123,20 @@ int main(int argc, char *argv[])
     close(fd);
     i8085_load_symbols(argv[2]);
     i8085_reset();
-    while(1)
-        i8085_exec(100000);
+    if (counting)
+        atexit(report_cycles);
+    if (profiling) {
+        profile_load(argv[2]);
+        atexit(profile_report);
+        profile_state();
+    }
+    if (!counting && !profiling)
+        while(1)
+            i8085_exec(100000);
+    /* One instruction at a time so the count is exact when we exit */
+    while(1) {
+        cycles += 1 - i8085_exec(1);
+        if (profiling)
+            profile_state();
+    }
 }
@@ -10,10 +10,12 @@
 #include <fcntl.h>
 #include "libz80/z80.h"
 #include "z80dis.h"
+#include "profile.h"
 
 static uint8_t ram[65536];
 static Z80Context cpu_z80;
 static unsigned trace;
+static unsigned long cycles;
 
 static uint8_t mem_read(int unused, uint16_t addr)
 {
@@ -91,16 +93,47 @@ static void z80_trace(unsigned unused)
 }
 
 
+/* -c: report the T-states used when the test exits */
+static unsigned counting;
+/* -p: report the T-states used by each function in the map */
+static unsigned profiling;
+
+static void report_cycles(void)
+{
+    fprintf(stderr, "CPU cycles = %lu\n", cycles + cpu_z80.tstates);
+}
+
+static void profile_state(void)
+{
+    uint16_t sp = cpu_z80.R1.wr.SP;
+    profile_step(cpu_z80.PC, sp, cycles + cpu_z80.tstates,
+        ram[sp] | (ram[(uint16_t)(sp + 1)] << 8));
+}
+
+/* Count the instruction that exited too */
+static void report_profile(void)
+{
+    profile_state();
+    profile_report();
+}
+
 int main(int argc, char *argv[])
 {
     int fd;
-    if (argc == 4 && strcmp(argv[1], "-d") == 0) {
+    while (argc > 1 && *argv[1] == '-') {
+        if (strcmp(argv[1], "-d") == 0)
+            trace = 1;
+        else if (strcmp(argv[1], "-c") == 0)
+            counting = 1;
+        else if (strcmp(argv[1], "-p") == 0)
+            profiling = 1;
+        else
+            break;
         argv++;
         argc--;
-        trace = 1;
     }
     if (argc != 3) {
-        fprintf(stderr, "emu85: test map.\n");
+        fprintf(stderr, "emuz80: [-d] [-c] [-p] test map.\n");
         exit(1);
     }
     fd = open(argv[1], O_RDONLY);
@@ -120,7 +153,20 @@ int main(int argc, char *argv[])
     cpu_z80.memRead = mem_read;
     cpu_z80.memWrite = mem_write;
     cpu_z80.trace = z80_trace;
+    if (counting)
+        atexit(report_cycles);
 
+    if (profiling) {
+        profile_load(argv[2]);
+        atexit(report_profile);
+        profile_state();
+        while(1) {
+            Z80Execute(&cpu_z80);
+            cycles += cpu_z80.tstates;
+            cpu_z80.tstates = 0;
+            profile_state();
+        }
+    }
     while(1)
-        Z80ExecuteTStates(&cpu_z80, 1000);
+        cycles += Z80ExecuteTStates(&cpu_z80, 1000);
 }
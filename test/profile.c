@@ -0,0 +1,194 @@
+/*
+ *	Per function cycle profile for the test emulators
+ *
+ *	The emulator calls profile_step() after each instruction with the
+ *	new PC and SP, the cycle count so far and the address a call would
+ *	have left on the top of the stack. The cycles of each instruction
+ *	are charged to the symbol from the map that encloses it. A call is
+ *	an instruction that pushed the address following it and went
+ *	somewhere else, and the callee is finished once the stack pointer
+ *	rises above where it was on entry. That also copes with helpers
+ *	that pop their caller's arguments and with longjmp.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "profile.h"
+
+struct symbol {
+	uint16_t addr;
+	char name[32];
+	unsigned long calls;
+	unsigned long self;
+	unsigned long incl;	/* Self plus everything called */
+	unsigned active;	/* Frames on the stack, for recursion */
+};
+
+struct frame {
+	unsigned sym;
+	uint16_t sp;
+	unsigned long start;
+};
+
+#define MAX_FRAME	256
+
+static struct symbol *symtab;
+static unsigned nsym;
+static uint16_t owner[65536];	/* Symbol index for each address */
+
+static struct frame frames[MAX_FRAME];
+static unsigned depth;
+static unsigned lost;		/* Calls too deep to track */
+
+static unsigned started;
+static uint16_t last_pc;
+static uint16_t last_sp;
+static unsigned long last_cycles;
+
+static void add_symbol(uint16_t addr, const char *name)
+{
+	struct symbol *s;
+	if ((nsym & 63) == 0) {
+		symtab = realloc(symtab, (nsym + 64) * sizeof(struct symbol));
+		if (symtab == NULL) {
+			fprintf(stderr, "profile: out of memory.\n");
+			exit(1);
+		}
+	}
+	s = symtab + nsym++;
+	memset(s, 0, sizeof(*s));
+	s->addr = addr;
+	strncpy(s->name, name, sizeof(s->name) - 1);
+}
+
+static int addr_order(const void *a, const void *b)
+{
+	const struct symbol *x = a;
+	const struct symbol *y = b;
+	return (int)x->addr - (int)y->addr;
+}
+
+static int self_order(const void *a, const void *b)
+{
+	const struct symbol *x = a;
+	const struct symbol *y = b;
+	if (x->self == y->self)
+		return strcmp(x->name, y->name);
+	return x->self < y->self ? 1 : -1;
+}
+
+/* Read the symbols from the linker map. Symbol 0 covers anything below
+   the first one */
+void profile_load(const char *map)
+{
+	char buf[128];
+	char name[64];
+	unsigned addr;
+	char type;
+	unsigned i, n;
+	FILE *fp = fopen(map, "r");
+
+	if (fp == NULL) {
+		perror(map);
+		exit(1);
+	}
+	add_symbol(0, "?");
+	while (fgets(buf, sizeof(buf), fp) != NULL) {
+		if (sscanf(buf, "%x %c %63s", &addr, &type, name) != 3)
+			continue;
+		/* Segment bounds are not functions */
+		if (strncmp(name, "__code_", 7) == 0 ||
+		    strncmp(name, "__data_", 7) == 0 ||
+		    strncmp(name, "__discard_", 10) == 0 ||
+		    strncmp(name, "__bss_", 6) == 0)
+			continue;
+		add_symbol(addr, name);
+	}
+	fclose(fp);
+	qsort(symtab + 1, nsym - 1, sizeof(struct symbol), addr_order);
+	n = 0;
+	for (i = 0; i < 65536; i++) {
+		while (n + 1 < nsym && symtab[n + 1].addr <= i)
+			n++;
+		owner[i] = n;
+	}
+}
+
+static void enter(unsigned sym, uint16_t sp, unsigned long cycles)
+{
+	struct frame *f;
+	if (depth == MAX_FRAME) {
+		lost++;
+		return;
+	}
+	f = frames + depth++;
+	f->sym = sym;
+	f->sp = sp;
+	f->start = cycles;
+	symtab[sym].calls++;
+	symtab[sym].active++;
+}
+
+static void leave(unsigned long cycles)
+{
+	struct frame *f = frames + --depth;
+	struct symbol *s = symtab + f->sym;
+	/* Only the outermost frame of a recursive function counts or we
+	   would add the same cycles more than once */
+	if (--s->active == 0)
+		s->incl += cycles - f->start;
+}
+
+void profile_step(uint16_t pc, uint16_t sp, unsigned long cycles, uint16_t ret)
+{
+	if (!started) {
+		started = 1;
+		last_pc = pc;
+		last_sp = sp;
+		last_cycles = cycles;
+		return;
+	}
+	symtab[owner[last_pc]].self += cycles - last_cycles;
+
+	if (sp == (uint16_t)(last_sp - 2) && ret > last_pc &&
+	    ret <= last_pc + 3 && pc != ret)
+		enter(owner[pc], sp, cycles);
+	else
+		while (depth && sp > frames[depth - 1].sp)
+			leave(cycles);
+
+	last_pc = pc;
+	last_sp = sp;
+	last_cycles = cycles;
+}
+
+void profile_report(void)
+{
+	unsigned long total = 0;
+	struct symbol *s;
+	unsigned i;
+
+	while (depth)
+		leave(last_cycles);
+	for (i = 0; i < nsym; i++)
+		total += symtab[i].self;
+	if (total == 0)
+		return;
+	qsort(symtab, nsym, sizeof(struct symbol), self_order);
+
+	fprintf(stderr, "%-24s %8s %12s %6s %12s %6s\n",
+		"function", "calls", "self", "%", "inclusive", "%");
+	for (i = 0; i < nsym; i++) {
+		s = symtab + i;
+		if (s->self == 0 && s->incl == 0)
+			continue;
+		fprintf(stderr, "%-24s %8lu %12lu %6.2f %12lu %6.2f\n",
+			s->name, s->calls, s->self, 100.0 * s->self / total,
+			s->incl, 100.0 * s->incl / total);
+	}
+	fprintf(stderr, "%-24s %8s %12lu\n", "total", "", total);
+	if (lost)
+		fprintf(stderr, "%u calls nested too deep to track\n", lost);
+}
@@ -0,0 +1,9 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+extern void profile_load(const char *map);
+extern void profile_step(uint16_t pc, uint16_t sp, unsigned long cycles,
+			 uint16_t ret);
+extern void profile_report(void);
+
+#endif
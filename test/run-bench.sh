@@ -0,0 +1,73 @@
+#!/bin/sh
+#
+#	Build the kernels in bench/ for each target and optimisation level,
+#	run them on the emulator and write target,opt,kernel,cycles,size,status
+#	as CSV. Compare two runs with bench-compare.sh.
+#
+#	run-bench.sh [-o file.csv] [target...]
+#
+#	OPTS sets the optimisation levels (default "-O0 -O1 -O2 -Os"),
+#	FCCLIB where the target libraries live (default /opt/fcc/lib)
+#
+OUT=
+if [ "$1" = "-o" ]; then
+	OUT=$2
+	shift 2
+fi
+TARGETS=${*:-"z80 8080 8085 6502 6800 6803 6809"}
+OPTS=${OPTS:-"-O0 -O1 -O2 -Os"}
+T=${TMPDIR:-/tmp}/bench.$$
+
+trap 'rm -f $T $T.o $T.map $T.err' 0
+
+. ./bench-target.sh
+
+# The code size from the map, or the image size if the map lacks it
+code_size()
+{
+	s=$(awk '$3 == "__code_size" { print $1 }' $T.map 2>/dev/null)
+	if [ -n "$s" ]; then
+		printf "%d\n" 0x$s
+	else
+		wc -c <$T | tr -d ' '
+	fi
+}
+
+run()
+{
+	echo "target,opt,kernel,cycles,size,status"
+	for t in $TARGETS
+	do
+		target $t || continue
+		for o in $OPTS
+		do
+			for i in bench/*.c
+			do
+				b=$(basename $i .c)
+				echo "$t $o $b" >&2
+				cycles=
+				size=
+				if ! fcc -m$t $o -c $i -o $T.o; then
+					status=compile
+				elif ! $LINK $T.o -o $T $LIBS -m $T.map; then
+					status=link
+				else
+					size=$(code_size)
+					if timeout 600 $EMU $T $T.map >/dev/null 2>$T.err; then
+						status=ok
+					else
+						status=fail
+					fi
+					cycles=$(sed -n 's/^CPU cycles = //p' $T.err)
+				fi
+				echo "$t,${o#-},$b,$cycles,$size,$status"
+			done
+		done
+	done
+}
+
+if [ -n "$OUT" ]; then
+	run >$OUT
+else
+	run
+fi
@@ -2,8 +2,11 @@
 for i in tests/*.c
 do
 	b=$(basename $i .c)
-	echo  $b":"
-	fcc  -Os -m8085 -c tests/$b.c
-	ld8080 -b -C0 testcrt0.o tests/$b.o -o tests/$b /opt/fcc/lib/8085/lib8085.a -m tests/$b.map
-	./emu85 tests/$b tests/$b.map
+	for o in -Os -O2 "-O2 --tree-opt"
+	do
+		echo  $b $o":"
+		fcc $o -m8085 -c tests/$b.c
+		ld8080 -b -C0 testcrt0.o tests/$b.o -o tests/$b /opt/fcc/lib/8085/lib8085.a -m tests/$b.map
+		./emu85 tests/$b tests/$b.map
+	done
 done
@@ -0,0 +1,151 @@
+#!/bin/sh
+#
+#	Code size of the test programs per function and per runtime helper
+#
+#	size-report.sh [-o file.csv] [target...]
+#	size-report.sh -d old.csv new.csv
+#
+#	The first form compiles and links each of tests/*.c and writes
+#	target,program,kind,symbol,bytes,refs as CSV. kind is func for a C
+#	function, helper for a runtime helper (__name) and other for the
+#	rest of the code, bytes is the distance to the next symbol in the
+#	map and refs the number of times the compiled C refers to the
+#	helper. OPT sets the optimisation level (default -Os).
+#
+#	The second form reports what changed between two runs and exits
+#	non zero if the code of any target grew by more than SLACK percent
+#	(default 0)
+#
+if [ "$1" = "-d" ]; then
+	if [ $# != 3 ]; then
+		echo "size-report.sh -d old.csv new.csv" >&2
+		exit 1
+	fi
+	awk -F, -v slack=${SLACK:-0} '
+	FNR == 1 { next }
+	NR == FNR {
+		old[$1 "," $2 "," $4] = $5
+		kind[$1 "," $2 "," $4] = $3
+		next
+	}
+	{
+		k = $1 "," $2 "," $4
+		seen[k] = 1
+		o = (k in old) ? old[k] : 0
+		if (o != $5)
+			printf("%-5s %-16s %-6s %-20s %6d -> %6d %+6d\n",
+				$1, $2, $3, $4, o, $5, $5 - o)
+		to[$1 "," $3] += o
+		tn[$1 "," $3] += $5
+		ot[$1] += o
+		nt[$1] += $5
+	}
+	END {
+		for (k in old) {
+			if (k in seen)
+				continue
+			split(k, f, ",")
+			printf("%-5s %-16s %-6s %-20s %6d -> %6s\n",
+				f[1], f[2], kind[k], f[3], old[k], "gone")
+			to[f[1] "," kind[k]] += old[k]
+			ot[f[1]] += old[k]
+		}
+		for (t in nt) {
+			printf("%-5s func %d -> %d, helper %d -> %d, total %d -> %d\n",
+				t, to[t ",func"], tn[t ",func"],
+				to[t ",helper"], tn[t ",helper"], ot[t], nt[t])
+			if (ot[t] && (nt[t] - ot[t]) * 100.0 / ot[t] > slack)
+				bad++
+		}
+		if (bad)
+			exit 1
+	}' "$2" "$3"
+	exit
+fi
+
+OUT=
+if [ "$1" = "-o" ]; then
+	OUT=$2
+	shift 2
+fi
+TARGETS=${*:-"z80 8080 8085 6502 6800 6803 6809"}
+OPT=${OPT:-"-Os"}
+T=${TMPDIR:-/tmp}/size.$$
+
+trap 'rm -f $T $T.s $T.o $T.map $T.sym $T.ref' 0
+
+. ./bench-target.sh
+
+# Helper references in the compiled C, as "name count"
+helper_refs()
+{
+	grep -v '^[A-Za-z0-9_]*:' $T.s | grep -v '^[ 	]*[.;]' |
+		grep -o '__[A-Za-z0-9_]*' | sort | uniq -c |
+		awk '{ print $2, $1 }'
+}
+
+# Size each symbol in the map up to the next one above it
+sizes()
+{
+	awk '
+	function hex(s,  i, v) {
+		v = 0
+		for (i = 1; i <= length(s); i++)
+			v = v * 16 + index("0123456789ABCDEF", toupper(substr(s, i, 1))) - 1
+		return v
+	}
+	NF == 3 { printf("%d %s %s\n", hex($1), $2, $3) }' $T.map |
+		grep -v ' __\(code\|data\|bss\|discard\)_' | sort -n -k1,1 -u >$T.sym
+	# Code is whatever segment main is in
+	code=$(awk '$3 == "_main" { print $2 }' $T.sym)
+	helper_refs >$T.ref
+	awk -v t=$1 -v p=$2 -v end=$(wc -c <$T) -v code="$code" '
+	BEGIN { n = 0 }
+	FILENAME ~ /\.ref$/ {
+		refs[$1] = $2
+		next
+	}
+	{
+		addr[n] = $1
+		type[n] = $2
+		name[n++] = $3
+	}
+	END {
+		for (i = 0; i < n; i++) {
+			s = (i + 1 < n ? addr[i + 1] : end) - addr[i]
+			if (s <= 0 || (code != "" && type[i] != code))
+				continue
+			k = "other"
+			if (name[i] ~ /^__/)
+				k = "helper"
+			else if (name[i] ~ /^_/)
+				k = "func"
+			printf("%s,%s,%s,%s,%d,%d\n", t, p, k, name[i], s,
+				refs[name[i]])
+		}
+	}' $T.ref $T.sym
+}
+
+run()
+{
+	echo "target,program,kind,symbol,bytes,refs"
+	for t in $TARGETS
+	do
+		target $t || continue
+		for i in tests/*.c
+		do
+			b=$(basename $i .c)
+			echo "$t $b" >&2
+			fcc -m$t $OPT -S $i -o $T.s &&
+			fcc -m$t -c $T.s -o $T.o &&
+			$LINK $T.o -o $T $LIBS -m $T.map &&
+			sizes $t $b
+		done
+	done
+}
+
+if [ -n "$OUT" ]; then
+	run >$OUT
+else
+	run
+fi
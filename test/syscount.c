@@ -0,0 +1,67 @@
+/*
+ *	Run a command and report the system call and byte counts from
+ *	/proc/pid/io along with the CPU time and peak memory used. Used by the compiler pass
+ *	benchmarks. Linux only.
+ *
+ *	syscount command [args...]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+int main(int argc, char *argv[])
+{
+	char path[64];
+	char buf[256];
+	siginfo_t info;
+	struct rusage ru;
+	FILE *fp;
+	pid_t pid;
+	int status;
+
+	if (argc < 2) {
+		fprintf(stderr, "%s: command [args...]\n", argv[0]);
+		exit(1);
+	}
+	pid = fork();
+	if (pid == -1) {
+		perror("fork");
+		exit(1);
+	}
+	if (pid == 0) {
+		execvp(argv[1], argv + 1);
+		perror(argv[1]);
+		_exit(255);
+	}
+	/* Wait for it to exit but leave the zombie so /proc/pid/io is
+	   still there to read */
+	if (waitid(P_PID, pid, &info, WEXITED | WNOWAIT) == -1) {
+		perror("waitid");
+		exit(1);
+	}
+	snprintf(path, sizeof(path), "/proc/%d/io", (int)pid);
+	fp = fopen(path, "r");
+	if (fp == NULL) {
+		perror(path);
+		exit(1);
+	}
+	while (fgets(buf, sizeof(buf), fp))
+		if (strncmp(buf, "sysc", 4) == 0 || strncmp(buf, "rchar", 5) == 0
+		    || strncmp(buf, "wchar", 5) == 0)
+			fputs(buf, stderr);
+	fclose(fp);
+	wait4(pid, &status, 0, &ru);
+	fprintf(stderr, "utime: %lu\nstime: %lu\nmaxrss: %lu\n",
+		ru.ru_utime.tv_sec * 1000000UL + ru.ru_utime.tv_usec,
+		ru.ru_stime.tv_sec * 1000000UL + ru.ru_stime.tv_usec,
+		(unsigned long)ru.ru_maxrss);
+	if (WIFEXITED(status))
+		return WEXITSTATUS(status);
+	return 1;
+}
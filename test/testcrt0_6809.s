@@ -26,6 +26,7 @@ tmp4:	.word	0
 	.code ; (at 0x0100)
 
 start:
+	lds	#$FE00	; below the I/O page
 	ldd	#0
 	std	@zero
 	ldd	#1
@@ -63,6 +63,7 @@ int main(int argc, char *argv[])
 {
     unsigned n;
     signed i;
+    register unsigned r;
     if (mul(0xFF,0xFF) != 65025U)
         return 1;
     if (mul(0xFF,0) != 0)
@@ -142,5 +143,14 @@ int main(int argc, char *argv[])
     i = 1;
     if (i / 2)
         return 34;
+    /* Unsigned divide of a register above 32767 */
+    r = 60000;
+    r %= 7;
+    if (r != 3)
+        return 35;
+    r = 60000;
+    r /= 7;
+    if (r != 8571)
+        return 36;
     return 0;
 }
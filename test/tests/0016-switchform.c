@@ -0,0 +1,142 @@
+/*
+ *	Switches that get a jump table or a binary searched table on the
+ *	targets that support them. Check the ends of each table, the values
+ *	just outside them and the gaps.
+ */
+
+static int sparse(int x)
+{
+    switch (x) {
+    case -30000:
+        return 1;
+    case -200:
+        return 2;
+    case -1:
+        return 3;
+    case 0:
+        return 4;
+    case 7:
+        return 5;
+    case 300:
+        return 6;
+    case 4096:
+        return 7;
+    case 32767:
+        return 8;
+    }
+    return 0;
+}
+
+static unsigned usparse(unsigned x)
+{
+    switch (x) {
+    case 0:
+        return 1;
+    case 3:
+        return 2;
+    case 90:
+        return 3;
+    case 1000:
+        return 4;
+    case 32768U:
+        return 5;
+    case 40000U:
+        return 6;
+    case 50000U:
+        return 7;
+    case 65535U:
+        return 8;
+    case 2:
+        return 9;
+    default:
+        return 0;
+    }
+}
+
+static int dense(int x)
+{
+    int r = 0;
+    switch (x) {
+    case -3:
+        r = 1;
+        break;
+    case -2:
+        r = 2;
+        break;
+    case 0:
+        r = 3;
+        /* Fall through */
+    case 1:
+        r += 4;
+        break;
+    case 2:
+        r = 5;
+        break;
+    default:
+        r = 9;
+    }
+    return r;
+}
+
+static int cdense(signed char c)
+{
+    switch (c) {
+    case -128:
+        return 1;
+    case -127:
+        return 2;
+    case -126:
+        return 3;
+    case -125:
+        return 4;
+    }
+    return 0;
+}
+
+static int ucdense(unsigned char c)
+{
+    switch (c) {
+    case 250:
+        return 1;
+    case 251:
+        return 2;
+    case 253:
+        return 3;
+    case 255:
+        return 4;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    static int sv[] = { -30000, -200, -1, 0, 7, 300, 4096, 32767 };
+    static unsigned uv[] = { 0, 3, 90, 1000, 32768U, 40000U, 50000U, 65535U };
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        if (sparse(sv[i]) != i + 1)
+            return 1;
+        if (usparse(uv[i]) != i + 1)
+            return 2;
+    }
+    if (usparse(2) != 9)
+        return 3;
+    if (sparse(-32768) || sparse(-2) || sparse(1) || sparse(32766))
+        return 4;
+    if (usparse(1) || usparse(4) || usparse(32767) || usparse(65534U))
+        return 5;
+    if (dense(-4) != 9 || dense(-3) != 1 || dense(-2) != 2 || dense(-1) != 9)
+        return 6;
+    if (dense(0) != 7 || dense(1) != 4 || dense(2) != 5 || dense(3) != 9)
+        return 7;
+    if (dense(-32768) != 9 || dense(32767) != 9)
+        return 8;
+    if (cdense(-128) != 1 || cdense(-125) != 4 || cdense(-124) || cdense(127))
+        return 9;
+    if (ucdense(250) != 1 || ucdense(253) != 3 || ucdense(255) != 4)
+        return 10;
+    if (ucdense(0) || ucdense(249) || ucdense(252) || ucdense(254))
+        return 11;
+    return 0;
+}
@@ -0,0 +1,108 @@
+/*
+ *	Locals whose address is never taken can be remembered across stores
+ *	through pointers. Check that and the cases where a store really does
+ *	change a local.
+ */
+
+struct pair {
+    int a;
+    int b;
+};
+
+int g;
+
+/* No address taken so *p cannot change x */
+static int keep(int *p, int a)
+{
+    int x;
+    x = a + 1;
+    *p = x + 1;
+    return x;
+}
+
+/* The address escapes so *p can change x */
+static int alias(int *p, int a)
+{
+    int x;
+    x = a + 1;
+    if (p == 0)
+        p = &x;
+    *p = 3;
+    return x;
+}
+
+/* A struct member store is a store to the local */
+static int member(int a)
+{
+    struct pair s;
+    s.a = a;
+    s.b = a + 1;
+    s.a = 7;
+    return s.a + s.b;
+}
+
+static int array(int *p, int a)
+{
+    int x[2];
+    int *q = x;
+    x[0] = a;
+    q[0] = a + 5;
+    *p = 1;
+    return x[0];
+}
+
+/* Clearing through p cannot change x */
+static int keepclr(unsigned char *p, int a)
+{
+    int x;
+    x = a + 1;
+    *p = 0;
+    return x;
+}
+
+/* Storing the value of x leaves it in the register for the return */
+static int keepstore(int *p, int a)
+{
+    int x;
+    x = a + 1;
+    *p = x;
+    return x;
+}
+
+/* A byte store changes half of x */
+static int halfclr(int a)
+{
+    int x;
+    unsigned char *p;
+    p = (unsigned char *)&x;
+    x = a;
+    *p = 0;
+    p[1] = 0;
+    return x;
+}
+
+int main(int argc, char *argv[])
+{
+    int v = 0;
+    unsigned char c = 1;
+
+    if (keep(&g, 4) != 5 || g != 6)
+        return 1;
+    if (keep(&v, 1) != 2 || v != 3)
+        return 2;
+    if (alias(0, 1) != 3)
+        return 3;
+    if (alias(&v, 1) != 2 || v != 3)
+        return 4;
+    if (member(2) != 10)
+        return 5;
+    if (array(&v, 1) != 6 || v != 1)
+        return 6;
+    if (halfclr(0x1234) != 0)
+        return 7;
+    if (keepclr(&c, 8) != 9 || c != 0)
+        return 8;
+    if (keepstore(&v, 5) != 6 || v != 6)
+        return 9;
+    return 0;
+}
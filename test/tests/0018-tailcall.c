@@ -0,0 +1,117 @@
+/*
+ *	Returns of the value of a call. Some targets turn these into a jump
+ *	so check the frame and registers are put back first and the
+ *	arguments end up in the right place.
+ */
+
+static int g;
+
+static int seven(void)
+{
+    return 7;
+}
+
+static int twice(int x)
+{
+    return x + x;
+}
+
+static long lval(int x)
+{
+    return 65536L * x + 1;
+}
+
+static int add(int a, int b)
+{
+    return a + b;
+}
+
+static int none(void)
+{
+    return seven();
+}
+
+static int same(int x)
+{
+    return twice(x);
+}
+
+static int changed(int x)
+{
+    return twice(x + 1);
+}
+
+static int local(int x)
+{
+    int y = x * 3;
+    return twice(y);
+}
+
+static int big(int x)
+{
+    int a[8];
+    a[7] = x;
+    g = a[7];
+    return twice(a[7] - 1);
+}
+
+static int keep(int x)
+{
+    register int r = x + 2;
+    return twice(r);
+}
+
+/* Our own argument goes on unchanged from under a frame and saved BC */
+static int under(int x)
+{
+    register int r = g;
+    int y = r + 1;
+    g = y + r;
+    return twice(x);
+}
+
+static long lcall(int x)
+{
+    return lval(x);
+}
+
+static int two(int x)
+{
+    return add(x, 4);
+}
+
+static int down(int n)
+{
+    if (n == 0)
+        return seven();
+    return down(n - 1);
+}
+
+int main(int argc, char *argv[])
+{
+    /* Must survive the calls that restore BC before they jump */
+    register int r = argc + 40;
+
+    if (none() != 7)
+        return 1;
+    if (same(3) != 6)
+        return 2;
+    if (changed(3) != 8)
+        return 3;
+    if (local(2) != 12)
+        return 4;
+    if (big(5) != 8 || g != 5)
+        return 5;
+    if (keep(1) != 6 || r != argc + 40)
+        return 6;
+    if (lcall(2) != 131073L)
+        return 7;
+    if (two(3) != 7)
+        return 8;
+    if (down(1000) != 7)
+        return 9;
+    g = 3;
+    if (under(4) != 8 || g != 7 || r != argc + 40)
+        return 10;
+    return 0;
+}
@@ -0,0 +1,212 @@
+/*
+ *	Locals and arguments the compiler moves into registers by itself.
+ *	Check they still hold the right values through loops, calls and the
+ *	operations that work on the register directly.
+ */
+
+static int twice(int x)
+{
+    return x + x;
+}
+
+static unsigned count(char *p)
+{
+    unsigned n = 0;
+    while (*p++)
+        n++;
+    return n;
+}
+
+static unsigned len(char *s)
+{
+    char *p = s;
+    while (*p)
+        p++;
+    return p - s;
+}
+
+static void copy(char *d, char *s)
+{
+    char *q = s;
+    while (*d++ = *q++)
+        ;
+}
+
+static char sum(char *p)
+{
+    char c = 0;
+    while (*p) {
+        c ^= *p;
+        c += 1;
+        p++;
+    }
+    return c;
+}
+
+/* The argument is the busiest variable */
+static int steps(int n)
+{
+    int s = 0;
+    while (n != 1) {
+        if (n & 1)
+            n = 3 * n + 1;
+        else
+            n >>= 1;
+        s++;
+    }
+    return s;
+}
+
+static unsigned bits(unsigned v)
+{
+    unsigned r = v;
+    r &= 0xFF0F;
+    r |= 0x0300;
+    r ^= 0x00F1;
+    r ^= 0x1000;
+    r &= 0xFFFE;
+    r |= twice(1);
+    return r;
+}
+
+static int calls(int a)
+{
+    int x = a;
+    x = twice(x);
+    x = twice(x) + x;
+    x = twice(x) - a;
+    return x;
+}
+
+/* The hot local is the last one so the frame shrinks under the others */
+static int shrink(int a, int b)
+{
+    int x = a;
+    int y = b;
+    int i;
+    for (i = 0; i < 10; i++)
+        y += i;
+    return x * 100 + y + a + b;
+}
+
+/* The array has its address used so the frame cannot shrink */
+static int noshrink(int a)
+{
+    int arr[3];
+    int *p = arr;
+    int i, n = 0;
+    for (i = 0; i < 3; i++)
+        p[i] = a + i;
+    for (i = 0; i < 3; i++)
+        n += arr[i];
+    return n + a;
+}
+
+/* Locals in blocks that end share their space */
+static int blocks(int a)
+{
+    int r = 0;
+    {
+        int i;
+        for (i = 0; i < a; i++)
+            r += 2;
+    }
+    {
+        unsigned char c = a;
+        c |= 0x80;
+        r += c;
+    }
+    return r;
+}
+
+/* The second argument moves, the first stays on the stack */
+static int second(int a, int n)
+{
+    int s = 0;
+    while (n) {
+        s += n;
+        n--;
+    }
+    return s + a;
+}
+
+static unsigned logic(unsigned v, unsigned m)
+{
+    unsigned r = v;
+    r &= m;
+    r ^= m >> 4;
+    r |= twice(2);
+    r &= ~m;
+    return r;
+}
+
+static unsigned char blogic(unsigned char v, unsigned char m)
+{
+    unsigned char c = v;
+    c &= 0xF3;
+    c |= 0x10;
+    c ^= 0x01;
+    c ^= m;
+    c &= m | 0x0F;
+    return c;
+}
+
+/* Enough busy variables for every register there is */
+static unsigned merge(char *d, char *a, char *b)
+{
+    unsigned n = 0;
+    while (*a && *b) {
+        *d++ = *a++;
+        *d++ = *b++;
+        n++;
+    }
+    *d = 0;
+    return n;
+}
+
+static int total(int *p, int n)
+{
+    int s = 0;
+    while (n--)
+        s += *p++;
+    return s;
+}
+
+int main(int argc, char *argv[])
+{
+    static int nums[4] = { 1000, -3, 20, 7 };
+    char buf[8];
+
+    if (count("hello") != 5)
+        return 1;
+    if (len("registers") != 9)
+        return 2;
+    copy(buf, "abc");
+    if (buf[0] != 'a' || buf[2] != 'c' || buf[3] != 0)
+        return 3;
+    if (sum("\001\002\003") != 3)
+        return 4;
+    if (steps(27) != 111)
+        return 5;
+    if (bits(0x1234) != 0x03F6)
+        return 6;
+    if (calls(3) != 33)
+        return 7;
+    if (shrink(1, 2) != 150)
+        return 8;
+    if (noshrink(4) != 19)
+        return 9;
+    if (blocks(3) != 137)
+        return 10;
+    if (second(1000, 10) != 1055)
+        return 11;
+    if (logic(0x1234, 0x00F0) != 0x000F)
+        return 12;
+    if (blogic(0x5A, 0x33) != 0x20)
+        return 13;
+    if (merge(buf, "ace", "bd") != 2 || buf[3] != 'd' || buf[4] != 0)
+        return 14;
+    if (total(nums, 4) != 1024)
+        return 15;
+    return 0;
+}
@@ -0,0 +1,73 @@
+/*
+ *	Leaf functions with a small frame return inline from each return
+ *	rather than through the shared exit. Check the frame and any saved
+ *	registers come off properly whichever way out is taken.
+ */
+
+static unsigned char classify(unsigned char c)
+{
+    unsigned char t;
+    t = c | 0x20;
+    if (t >= 'a' && t <= 'z')
+        return 1;
+    if (c >= '0' && c <= '9')
+        return 2;
+    return 0;
+}
+
+static int scan(char *p)
+{
+    int n = 0;
+    int last = 0;
+    while (*p) {
+        if (*p == ';')
+            return n;
+        if (*p != last)
+            n++;
+        last = *p++;
+    }
+    return -n;
+}
+
+static void step(int *p, int by)
+{
+    int v = *p;
+    if (v > 100) {
+        *p = 0;
+        return;
+    }
+    *p = v + by;
+}
+
+/* Too big a frame for the inline exit */
+static long mix(long a, long b)
+{
+    long x = a + b;
+    long y = a - b;
+    if (x == 0)
+        return y;
+    return x ^ y;
+}
+
+int main(int argc, char *argv[])
+{
+    int v = 99;
+
+    if (classify('Q') != 1 || classify('7') != 2 || classify('#') != 0)
+        return 1;
+    if (scan("aabbc;dd") != 3)
+        return 2;
+    if (scan("abc") != -3)
+        return 3;
+    step(&v, 2);
+    if (v != 101)
+        return 4;
+    step(&v, 2);
+    if (v != 0)
+        return 5;
+    if (mix(5, -5) != 10)
+        return 6;
+    if (mix(6, 2) != 12)
+        return 7;
+    return 0;
+}
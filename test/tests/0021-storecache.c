@@ -0,0 +1,45 @@
+/*
+ *	A store through a pointer can change a global the code generator
+ *	still has a copy of in a register. Check the copy is not used after
+ *	the store on any of the store paths (8085 shlx in particular).
+ */
+
+int g;
+unsigned char cg;
+
+/* The copy of g lives on in BC */
+static int reread(int *p)
+{
+    register int r;
+    r = g;
+    *p = 5;
+    return g - r;
+}
+
+static int reread_byte(unsigned char *p)
+{
+    register unsigned char r;
+    r = cg;
+    *p = 9;
+    return cg - r;
+}
+
+static int overwrite(int *p)
+{
+    g = 7;
+    *p = 3;
+    return g;
+}
+
+int main(int argc, char *argv[])
+{
+    g = 1;
+    if (reread(&g) != 4)
+        return 1;
+    cg = 2;
+    if (reread_byte(&cg) != 7)
+        return 2;
+    if (overwrite(&g) != 3)
+        return 3;
+    return 0;
+}
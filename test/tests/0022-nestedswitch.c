@@ -0,0 +1,42 @@
+/*
+ *	A switch inside a switch has its own default, or none. Check that the
+ *	outer default does not leak into the inner switch either way.
+ */
+
+static int pick(int a, int b)
+{
+    switch (a) {
+    default:
+        /* No default here, unmatched values go on past it */
+        switch (b) {
+        case 1:
+            return 10;
+        case 2:
+            return 11;
+        }
+        return 20;
+    case 5:
+        switch (b) {
+        case 2:
+            return 30;
+        default:
+            return 40;
+        }
+    case 6:
+        break;
+    }
+    return 50;
+}
+
+int main(int argc, char *argv[])
+{
+    if (pick(0, 1) != 10 || pick(0, 2) != 11)
+        return 1;
+    if (pick(0, 7) != 20)
+        return 2;
+    if (pick(5, 2) != 30 || pick(5, 3) != 40)
+        return 3;
+    if (pick(6, 2) != 50)
+        return 4;
+    return 0;
+}
@@ -0,0 +1,47 @@
+/*
+ *	Deeply nested expressions. These need several hundred tree nodes
+ *	at once, more than the fixed node table native builds use.
+ */
+
+unsigned left(unsigned a, unsigned b)
+{
+    return
+        ((((((((((((((((((((((((((((((((((((((((((((((((((((((((((((((((((((((((((((((((a
+            ^ a) - 14) | b) + a) & (35 | 0xFF0F)) - b) ^ a) + 56) ^ b) - a)
+            | 77) + b) & (a | 0xFF0F)) - 98) ^ b) + a) ^ 119) - b) | a) +
+            140) & (b | 0xFF0F)) - a) ^ 161) + b) ^ a) - 182) | b) + a) &
+            (203 | 0xFF0F)) - b) ^ a) + 224) ^ b) - a) | 245) + b) & (a |
+            0xFF0F)) - 266) ^ b) + a) ^ 287) - b) | a) + 308) & (b |
+            0xFF0F)) - a) ^ 329) + b) ^ a) - 350) | b) + a) & (371 |
+            0xFF0F)) - b) ^ a) + 392) ^ b) - a) | 413) + b) & (a | 0xFF0F))
+            - 434) ^ b) + a) ^ 455) - b) | a) + 476) & (b | 0xFF0F)) - a) ^
+            497) + b) ^ a) - 518) | b) + a) & (539 | 0xFF0F)) - b) ^ a) +
+            560);
+}
+
+unsigned right(unsigned a, unsigned b)
+{
+    return
+        (560 + (a ^ (b - ((539 | 0xFF0F) & (a + (b | (518 - (a ^ (b + (497
+            ^ (a - ((b | 0xFF0F) & (476 + (a | (b - (455 ^ (a + (b ^ (434 -
+            ((a | 0xFF0F) & (b + (413 | (a - (b ^ (392 + (a ^ (b - ((371 |
+            0xFF0F) & (a + (b | (350 - (a ^ (b + (329 ^ (a - ((b | 0xFF0F)
+            & (308 + (a | (b - (287 ^ (a + (b ^ (266 - ((a | 0xFF0F) & (b +
+            (245 | (a - (b ^ (224 + (a ^ (b - ((203 | 0xFF0F) & (a + (b |
+            (182 - (a ^ (b + (161 ^ (a - ((b | 0xFF0F) & (140 + (a | (b -
+            (119 ^ (a + (b ^ (98 - ((a | 0xFF0F) & (b + (77 | (a - (b ^ (56
+            + (a ^ (b - ((35 | 0xFF0F) & (a + (b | (14 - (a ^
+            a))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))));
+}
+
+static unsigned ca = 1234;
+static unsigned cb = 0x5A5;
+
+int main(int argc, char *argv[])
+{
+    if (left(ca, cb) != 0x02E0)
+        return 1;
+    if (right(ca, cb) != 0xF97C)
+        return 2;
+    return 0;
+}
@@ -9,15 +9,33 @@
 
 #include "compiler.h"
 
-static struct node node_table[NUM_NODES];
 static struct node *nodes;
 
+#ifdef NODE_SLABS
+/* Nodes are never given back to malloc, just kept on the free list */
+static void node_slab(void)
+{
+	register int i;
+	register struct node *n = malloc(NUM_NODES * sizeof(struct node));
+	if (n == NULL)
+		fatal("out of memory");
+	for (i = 0; i < NUM_NODES; i++)
+		free_node(n++);
+}
+#else
+static struct node node_table[NUM_NODES];
+#endif
+
 struct node *new_node(void)
 {
 	register struct node *n;
 	if (nodes == NULL) {
+#ifdef NODE_SLABS
+		node_slab();
+#else
 		error("too complex");
 		exit(1);
+#endif
 	}
 	n = nodes;
 	nodes = n->right;
@@ -37,10 +55,14 @@ void free_node(struct node *n)
 
 void init_nodes(void)
 {
+#ifdef NODE_SLABS
+	node_slab();
+#else
 	register int i;
 	register struct node *n = node_table;
 	for (i = 0; i < NUM_NODES; i++)
 		free_node(n++);
+#endif
 }
 
 
@@ -261,26 +283,89 @@ void free_tree(register struct node *n)
 	free_node(n);
 }
 
-static void write_subtree(register struct node *n)
+/* Operators that write their left */
+static unsigned is_assign(unsigned op)
+{
+	switch(op) {
+	case T_EQ:
+	case T_PLUSPLUS:
+	case T_MINUSMINUS:
+	case T_PLUSEQ:
+	case T_MINUSEQ:
+	case T_STAREQ:
+	case T_SLASHEQ:
+	case T_PERCENTEQ:
+	case T_SHLEQ:
+	case T_SHREQ:
+	case T_ANDEQ:
+	case T_OREQ:
+	case T_HATEQ:
+		return 1;
+	}
+	return 0;
+}
+
+/* The type n reads or writes its child c as directly, if it does */
+static unsigned direct_use(register struct node *n, struct node *c)
 {
+	if (n->op == T_DEREF && c == n->right && !(n->flags & SIDEEFFECT))
+		/* A load used as an address is typed as what it points to */
+		return n->type + !!(n->flags & LVAL);
+	if (c == n->left && is_assign(n->op))
+		return n->op == T_EQ ? n->type : c->type;
+	return VOID;
+}
+
+static void write_subtree(register struct node *n, unsigned use)
+{
+	/* See assign_regvars */
+	if (n->op == T_LOCAL || n->op == T_ARGUMENT)
+		note_regvar(n, use);
 	/* Replace the array code with the simple type info of the
 	   node for the backend, otherwise some backends cannot work
 	   out how to access the object (Think word addressing/bytepointers) */
 	if (IS_ARRAY(n->type)) {
 		n->type = PTRTO + array_type(n->type);
 	}
+	if (n->op == T_FUNCCALL)
+		func_flags &= ~F_LEAF;
 	out_block(n, sizeof(struct node));
 	if (n->left)
-		write_subtree(n->left);
+		write_subtree(n->left, direct_use(n, n->left));
 	if (n->right)
-		write_subtree(n->right);
+		write_subtree(n->right, direct_use(n, n->right));
 	free_node(n);
 }
 
+/*
+ *	Is the address of a local or argument used for anything but getting
+ *	at it directly ? That is to read it or as the target of an assignment,
+ *	maybe with a constant added for a struct member. Anything else, from
+ *	&x to an array decaying to a pointer, means something else may be
+ *	able to reach it.
+ */
+static unsigned addr_taken(register struct node *n, unsigned direct)
+{
+	register struct node *r = n->right;
+
+	if (n->op == T_LOCAL || n->op == T_ARGUMENT)
+		return !direct;
+	if (n->op == T_DEREF)
+		return r && addr_taken(r, 1);
+	if (n->op == T_PLUS && r && r->op == T_CONSTANT)
+		return addr_taken(n->left, direct);
+	if (n->left && addr_taken(n->left, is_assign(n->op)))
+		return 1;
+	return r && addr_taken(r, 0);
+}
+
 void write_tree(struct node *n)
 {
+	/* See F_LEAF and F_NOADDR */
+	if (addr_taken(n, 0))
+		func_flags &= ~(F_LEAF | F_NOADDR);
 	out_block("%^", 2);
-	write_subtree(n);
+	write_subtree(n, VOID);
 }
 
 void write_null_tree(void)